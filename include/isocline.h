@@ -37,6 +37,7 @@ Contents:
 - \ref completex
 - \ref term
 - \ref async
+- \ref env
 - \ref alloc
 */
 
@@ -103,8 +104,39 @@ void ic_printf(const char* fmt, ...);
 /// @see ic_print
 void ic_vprintf(const char* fmt, va_list args);
 
+/// Enable or disable the integrated pager for printing (disabled by default).
+/// When enabled, ic_print() pauses after each screenful with a `--more--`
+/// prompt: press `space` for the next page, `enter` for the next line, and
+/// `q` (or `esc`) to skip the remaining output. Paging only happens on an
+/// interactive terminal. Returns the previous setting.
+/// @see ic_print()
+bool ic_enable_pager( bool enable );
+
+/// A precompiled bbcode markup template.
+/// The markup is parsed and its styles are resolved once; printing the
+/// template afterwards needs no parsing or style lookups anymore.
+/// @see ic_bbcode_template_new(), ic_print_template()
+struct ic_bbcode_template_s;
+typedef struct ic_bbcode_template_s ic_bbcode_template_t;
+
+/// Compile bbcode markup into a template for repeated printing.
+/// Every `%s` in the markup is a substitution slot that is filled by an
+/// argument in ic_print_template() (use `%%` for a literal `%`).
+/// Returns NULL on failure; free with ic_bbcode_template_free().
+/// @see ic_print()
+ic_bbcode_template_t* ic_bbcode_template_new( const char* s );
+
+/// Free a template compiled with ic_bbcode_template_new() (can be NULL).
+void ic_bbcode_template_free( ic_bbcode_template_t* tpl );
+
+/// Print a precompiled template, substituting `args[0]` to `args[arg_count-1]`
+/// for the `%s` slots. Arguments are plain text (not markup) and are printed
+/// with the style that is active at their slot; missing arguments print as empty.
+/// @see ic_bbcode_template_new()
+void ic_print_template( const ic_bbcode_template_t* tpl, const char** args, size_t arg_count );
+
 /// Define or redefine a style.
-/// @param style_name The name of the style. 
+/// @param style_name The name of the style.
 /// @param fmt        The `fmt` string is the content of a tag and can contain
 ///   other styles. This is very useful to theme the output of a program
 ///   by assigning standard styles like `em` or `warning` etc.
@@ -231,7 +263,52 @@ typedef bool (ic_is_char_class_fun_t)(const char* s, long len);
 void ic_complete_word(ic_completion_env_t* cenv, const char* prefix, ic_completer_fun_t* fun, ic_is_char_class_fun_t* is_word_char);
 
 
-/// Complete a quoted _word_. 
+/// An entry for ic_completer_from_words(): a completion with an optional
+/// display and help (as shown in the completion menu and hints).
+/// Both `display` and `help` can be NULL.
+typedef struct ic_completion_entry_s {
+  const char* replacement;
+  const char* display;
+  const char* help;
+} ic_completion_entry_t;
+
+/// A prebuilt completer over a fixed word (or command) table.
+/// The table is sorted and interned once at creation so every prefix query
+/// finds its matching range by binary search (in `O(log n)`) instead of
+/// scanning the whole list on each tab press and hint.
+/// @see ic_completer_from_words()
+struct ic_completer_s;
+typedef struct ic_completer_s ic_completer_t;
+
+/// Create a prebuilt completer from a table of `count` entries.
+/// The entries are copied (and sorted) so the table does not need to be preserved.
+/// Returns NULL on failure; free with ic_completer_free().
+ic_completer_t* ic_completer_from_words( const ic_completion_entry_t* entries, size_t count );
+
+/// Free a completer created with ic_completer_from_words() (can be NULL).
+void ic_completer_free( ic_completer_t* completer );
+
+/// In a completion callback, add all words from a prebuilt completer that
+/// match `prefix` (found by binary search over the sorted table).
+/// Returns `true` if the callback should continue adding completions.
+/// @see ic_add_completions()
+bool ic_add_completions_from( ic_completion_env_t* cenv, const char* prefix, const ic_completer_t* completer );
+
+/// Complete the current _word_ from a prebuilt completer.
+/// Combines ic_complete_word() and ic_add_completions_from(); if `is_word_char`
+/// is NULL, the default `&ic_char_is_nonseparator` is used.
+void ic_complete_word_from( ic_completion_env_t* cenv, const char* prefix, const ic_completer_t* completer,
+                                ic_is_char_class_fun_t* is_word_char );
+
+/// An ic_completer_fun_t that completes words from a prebuilt completer
+/// passed as the completer argument, so a word table plugs in directly:
+/// ```
+/// ic_set_default_completer( &ic_completer_word_fun, completer );
+/// ```
+void ic_completer_word_fun( ic_completion_env_t* cenv, const char* prefix );
+
+
+/// Complete a quoted _word_.
 /// Calls the user provided function `fun` to complete while taking
 /// care of quotes and escape characters. Almost all user provided completers should use
 /// this function. The `prefix` passed to `fun` is modified to be unquoted and unescaped, and 
@@ -352,6 +429,14 @@ bool ic_enable_history_duplicates( bool enable );
 /// Returns the previous setting.
 bool ic_enable_auto_tab( bool enable );
 
+/// Disable or enable fuzzy completion matching (disabled by default).
+/// When enabled, the typed characters only need to occur in order in a
+/// candidate (so `gco` can complete to `git checkout`): ic_add_completions()
+/// accepts such subsequence matches and the completion menu orders the
+/// candidates by match quality instead of alphabetically.
+/// Returns the previous setting.
+bool ic_enable_fuzzy_completion( bool enable );
+
 /// Disable or enable preview of a completion selection (enabled by default)
 /// Returns the previous setting.
 bool ic_enable_completion_preview( bool enable );
@@ -379,6 +464,14 @@ long ic_set_hint_delay(long delay_ms);
 /// Returns the previous setting.
 bool ic_enable_highlight(bool enable);
 
+/// Enable or disable incremental syntax highlighting (disabled by default).
+/// When enabled, after an edit the highlighter callback is rerun only from the start of the
+/// line containing the edit (instead of over the whole input) and the fresh attributes are
+/// spliced into the cached ones. Only enable this if your highlighter does not need to look
+/// backward across line boundaries (for example, for multi-line strings or comments).
+/// Returns the previous setting.
+bool ic_enable_incremental_highlight(bool enable);
+
 
 /// Set millisecond delay for reading escape sequences in order to distinguish
 /// a lone ESC from the start of a escape sequence. The defaults are 100ms and 10ms, 
@@ -594,6 +687,102 @@ int ic_term_get_color_bits( void );
 /// functional on Linux, macOS and Windows).
 bool ic_async_stop(void);
 
+/// Start a non-blocking (poll based) readline for use in an event loop.
+/// The prompt is displayed and the terminal is put in raw mode; keep
+/// calling ic_readline_poll() whenever input is available on the tty
+/// (see ic_readline_fd()). Returns `false` if a session is already
+/// active or if rich editing is not available (e.g. reading from a pipe).
+bool ic_readline_start(const char* prompt_text);
+
+/// Advance an active non-blocking readline; processes all input that is
+/// currently available without ever blocking. Returns `true` when the line
+/// is finished: `*line` is set to the entered line (free with ic_free()),
+/// or to NULL when the user canceled with ctrl-C or ctrl-D. Returns `false`
+/// while editing is still in progress (or when no session is active).
+/// Note: modal interactions (like the completion menu or the history
+/// search) still read their keys directly from the tty.
+bool ic_readline_poll(char** line);
+
+/// Feed input bytes to an active non-blocking readline as if they were
+/// typed (processed at the next ic_readline_poll()). Reads up to `len`
+/// bytes from `input` (or up to the 0 terminator if `len < 0`).
+/// Returns how many bytes were accepted -- the internal buffer is small
+/// so feed the remainder again after polling.
+long ic_readline_feed(const char* input, long len);
+
+/// The file descriptor of the tty input (to wait on with `select` etc
+/// in an event loop). Returns -1 if unavailable (e.g. on Windows or when
+/// reading from a pipe).
+int ic_readline_fd(void);
+
+/// \}
+
+//--------------------------------------------------------------
+/// \defgroup stats Statistics
+/// Hot-path instrumentation counters. These are only collected
+/// when the library is compiled with `IC_STATS` defined (cmake
+/// option `IC_STATS`); in a default build the counters stay zero
+/// and the hot path pays nothing.
+/// \{
+
+/// Instrumentation counters; times are in nanoseconds.
+typedef struct ic_stats_s {
+  uint64_t tty_read_count;      ///< low-level key reads (including timeouts)
+  uint64_t tty_read_nsecs;      ///< total time spent (waiting) in key reads
+  uint64_t refresh_count;       ///< full editor refreshes
+  uint64_t refresh_nsecs;       ///< total time spent in editor refreshes
+  uint64_t highlight_count;     ///< highlighter callback invocations
+  uint64_t highlight_nsecs;     ///< total time spent in the highlighter callback
+  uint64_t term_flush_count;    ///< terminal buffer flushes
+  uint64_t term_flush_nsecs;    ///< total time spent flushing
+  uint64_t term_write_count;    ///< `write` calls to the terminal
+  uint64_t term_write_bytes;    ///< bytes written to the terminal
+} ic_stats_t;
+
+/// Get the current counters; returns `false` (and all zeros)
+/// if the library was not compiled with `IC_STATS`.
+bool ic_get_stats( ic_stats_t* stats );
+
+/// Reset all counters to zero.
+void ic_reset_stats(void);
+
+/// \}
+
+//--------------------------------------------------------------
+/// \defgroup env Explicit Environments
+/// Explicit environment handles for multiple concurrent sessions.
+/// The regular API implicitly targets one global environment (reading
+/// from `stdin`); with an explicit handle each session owns its own
+/// terminal, history, and completions so many sessions (on different
+/// pty's for example) can run concurrently in one process -- each
+/// handle should only be used from one thread at a time though.
+/// \{
+
+/// An isocline environment.
+struct ic_env_s;
+typedef struct ic_env_s ic_env_t;
+
+/// Create a new environment reading from `fd_in` and writing to `fd_out`
+/// (pass -1 to use `stdin`/`stdout`). Returns NULL on failure.
+/// Free with ic_env_free().
+ic_env_t* ic_env_new(int fd_in, int fd_out);
+
+/// Release an environment created with ic_env_new()
+/// (this also saves its history if a history file was set).
+void ic_env_free(ic_env_t* env);
+
+/// As ic_readline() but reading from an explicit environment.
+char* ic_env_readline(ic_env_t* env, const char* prompt_text);
+
+/// As ic_set_history() but for an explicit environment.
+void ic_env_set_history(ic_env_t* env, const char* fname, long max_entries);
+
+/// As ic_set_default_completer() but for an explicit environment.
+void ic_env_set_default_completer(ic_env_t* env, ic_completer_fun_t* completer, void* arg);
+
+/// As ic_set_default_highlighter() but for an explicit environment.
+void ic_env_set_default_highlighter(ic_env_t* env, ic_highlight_fun_t* highlighter, void* arg);
+
 /// \}
 
 //--------------------------------------------------------------
@@ -171,49 +171,133 @@ ic_private attr_t attr_from_esc_sgr( const char* s, ssize_t len) {
 
 //-------------------------------------------------------------
 // Attribute buffer
+// Stored run-length encoded as spans of identical attributes:
+// appending a span is O(1), range set/update only touches the
+// overlapped runs, and rendering can walk whole runs instead of
+// comparing per-byte attributes. A flat per-byte view is
+// materialized lazily for clients that index directly.
 //-------------------------------------------------------------
+
+typedef struct attrspan_s {
+  attr_t  attr;
+  ssize_t count;
+} attrspan_t;
+
 struct attrbuf_s {
-  attr_t*  attrs;
-  ssize_t  capacity;
-  ssize_t  count;
+  attrspan_t* runs;
+  ssize_t  run_count;
+  ssize_t  run_capacity;
+  ssize_t  count;          // total bytes covered by the runs
+  attr_t*  flat;           // lazily materialized per-byte view (see attrbuf_attrs)
+  ssize_t  flat_capacity;
+  bool     flat_valid;
   alloc_t* mem;
 };
 
-static bool attrbuf_ensure_capacity( attrbuf_t* ab, ssize_t needed ) {
-  if (needed <= ab->capacity) return true;
-  ssize_t newcap = (ab->capacity <= 0 ? 240 : (ab->capacity > 1000 ? ab->capacity + 1000 : 2*ab->capacity));
+static bool attrbuf_runs_ensure( attrbuf_t* ab, ssize_t needed ) {
+  if (needed <= ab->run_capacity) return true;
+  ssize_t newcap = (ab->run_capacity <= 0 ? 32 : 2*ab->run_capacity);
   if (needed > newcap) { newcap = needed; }
-  attr_t* newattrs = mem_realloc_tp( ab->mem, attr_t, ab->attrs, newcap );
-  if (newattrs == NULL) return false;
-  ab->attrs = newattrs;
-  ab->capacity = newcap;
-  assert(needed <= ab->capacity);
+  attrspan_t* newruns = mem_realloc_tp( ab->mem, attrspan_t, ab->runs, newcap );
+  if (newruns == NULL) return false;
+  ab->runs = newruns;
+  ab->run_capacity = newcap;
   return true;
 }
 
-static bool attrbuf_ensure_extra( attrbuf_t* ab, ssize_t extra ) {
-  const ssize_t needed = ab->count + extra;
-  return attrbuf_ensure_capacity( ab, needed );
+// open up `n` uninitialized runs at index `idx`
+static bool attrbuf_runs_open( attrbuf_t* ab, ssize_t idx, ssize_t n ) {
+  if (!attrbuf_runs_ensure(ab, ab->run_count + n)) return false;
+  ic_memmove( ab->runs + idx + n, ab->runs + idx, (ab->run_count - idx)*ssizeof(attrspan_t) );
+  ab->run_count += n;
+  return true;
 }
 
+static void attrbuf_runs_close( attrbuf_t* ab, ssize_t idx, ssize_t n ) {
+  if (n <= 0) return;
+  ic_memmove( ab->runs + idx, ab->runs + idx + n, (ab->run_count - idx - n)*ssizeof(attrspan_t) );
+  ab->run_count -= n;
+}
+
+// find the run containing `pos`; sets `ofs` to the byte offset of the run start.
+// (returns run_count with ofs == count if pos is at or beyond the end)
+static ssize_t attrbuf_run_find( const attrbuf_t* ab, ssize_t pos, ssize_t* ofs ) {
+  ssize_t start = 0;
+  for (ssize_t i = 0; i < ab->run_count; i++) {
+    if (pos < start + ab->runs[i].count) {
+      *ofs = start;
+      return i;
+    }
+    start += ab->runs[i].count;
+  }
+  *ofs = start;
+  return ab->run_count;
+}
+
+// split runs so a run boundary falls exactly at `pos`;
+// returns the index of the run starting at `pos`.
+static ssize_t attrbuf_run_split( attrbuf_t* ab, ssize_t pos ) {
+  ssize_t ofs;
+  const ssize_t i = attrbuf_run_find(ab, pos, &ofs);
+  if (i >= ab->run_count || pos == ofs) return i;
+  if (!attrbuf_runs_open(ab, i+1, 1)) return i;  // on allocation failure leave as-is
+  ab->runs[i+1].attr  = ab->runs[i].attr;
+  ab->runs[i+1].count = ofs + ab->runs[i].count - pos;
+  ab->runs[i].count   = pos - ofs;
+  return i+1;
+}
+
+// merge equal adjacent runs in the index window [idx-1, idx+n]
+static void attrbuf_runs_merge( attrbuf_t* ab, ssize_t idx, ssize_t n ) {
+  ssize_t i = (idx <= 0 ? 1 : idx);
+  ssize_t last = idx + n;
+  while (i < ab->run_count && i <= last) {
+    if (attr_is_eq(ab->runs[i-1].attr, ab->runs[i].attr)) {
+      ab->runs[i-1].count += ab->runs[i].count;
+      attrbuf_runs_close(ab, i, 1);
+      last--;
+    }
+    else {
+      i++;
+    }
+  }
+}
+
+// O(1) append of a span (coalesces with the last run)
+static void attrbuf_append_span( attrbuf_t* ab, attr_t attr, ssize_t count ) {
+  if (count <= 0) return;
+  ab->flat_valid = false;
+  if (ab->run_count > 0 && attr_is_eq(ab->runs[ab->run_count-1].attr, attr)) {
+    ab->runs[ab->run_count-1].count += count;
+  }
+  else {
+    if (!attrbuf_runs_ensure(ab, ab->run_count + 1)) return;
+    ab->runs[ab->run_count].attr  = attr;
+    ab->runs[ab->run_count].count = count;
+    ab->run_count++;
+  }
+  ab->count += count;
+}
 
 ic_private attrbuf_t* attrbuf_new( alloc_t* mem ) {
   attrbuf_t* ab = mem_zalloc_tp(mem,attrbuf_t);
   if (ab == NULL) return NULL;
   ab->mem = mem;
-  attrbuf_ensure_extra(ab,1);
   return ab;
 }
 
 ic_private void attrbuf_free( attrbuf_t* ab ) {
   if (ab==NULL) return;
-  mem_free(ab->mem, ab->attrs);
+  mem_free(ab->mem, ab->runs);
+  mem_free(ab->mem, ab->flat);
   mem_free(ab->mem, ab);
 }
 
 ic_private void attrbuf_clear(attrbuf_t* ab) {
   if (ab == NULL) return;
+  ab->run_count = 0;
   ab->count = 0;
+  ab->flat_valid = false;
 }
 
 ic_private ssize_t attrbuf_len( attrbuf_t* ab ) {
@@ -223,33 +307,64 @@ ic_private ssize_t attrbuf_len( attrbuf_t* ab ) {
 ic_private const attr_t* attrbuf_attrs( attrbuf_t* ab, ssize_t expected_len ) {
   assert(expected_len <= ab->count );
   // expand if needed
-  if (ab->count < expected_len) {    
-    if (!attrbuf_ensure_capacity(ab,expected_len)) return NULL;
-    for(ssize_t i = ab->count; i < expected_len; i++) {
-      ab->attrs[i] = attr_none();  
+  if (ab->count < expected_len) {
+    attrbuf_append_span(ab, attr_none(), expected_len - ab->count);
+  }
+  // materialize the flat per-byte view
+  if (!ab->flat_valid || ab->flat == NULL) {
+    if (ab->count > ab->flat_capacity) {
+      ssize_t newcap = (ab->flat_capacity <= 0 ? 240 : (ab->flat_capacity > 1000 ? ab->flat_capacity + 1000 : 2*ab->flat_capacity));
+      if (ab->count > newcap) { newcap = ab->count; }
+      attr_t* newflat = mem_realloc_tp( ab->mem, attr_t, ab->flat, newcap );
+      if (newflat == NULL) return NULL;
+      ab->flat = newflat;
+      ab->flat_capacity = newcap;
     }
-    ab->count = expected_len;
+    ssize_t pos = 0;
+    for (ssize_t i = 0; i < ab->run_count; i++) {
+      for (ssize_t j = 0; j < ab->runs[i].count; j++) {
+        ab->flat[pos++] = ab->runs[i].attr;
+      }
+    }
+    ab->flat_valid = true;
   }
-  return ab->attrs;
+  return ab->flat;
 }
 
 
-
 static void attrbuf_update_set_at( attrbuf_t* ab, ssize_t pos, ssize_t count, attr_t attr, bool update ) {
+  if (ab == NULL || pos < 0 || count <= 0) return;
   const ssize_t end = pos + count;
-  if (!attrbuf_ensure_capacity(ab, end)) return;
-  ssize_t i;
-  // initialize if end is beyond the count (todo: avoid duplicate init and set if update==false?)
-  if (ab->count < end) {
-    for(i = ab->count; i < end; i++) {
-      ab->attrs[i] = attr_none();  
+  ab->flat_valid = false;
+  // extend with default attributes up to `end` if needed
+  ssize_t hi = end;
+  if (end > ab->count) {
+    const ssize_t oldcount = ab->count;
+    const attr_t extattr = (update ? attr_update_with(attr_none(),attr) : attr);
+    if (pos >= oldcount) {
+      if (pos > oldcount) { attrbuf_append_span(ab, attr_none(), pos - oldcount); }
+      attrbuf_append_span(ab, extattr, end - pos);
+      return;
     }
-    ab->count = end;
+    attrbuf_append_span(ab, extattr, end - oldcount);
+    hi = oldcount;
+  }
+  // transform the existing range [pos,hi)
+  const ssize_t lo_run = attrbuf_run_split(ab, pos);
+  const ssize_t hi_run = attrbuf_run_split(ab, hi);  // one past the last affected run
+  if (update) {
+    for (ssize_t i = lo_run; i < hi_run; i++) {
+      ab->runs[i].attr = attr_update_with(ab->runs[i].attr, attr);
+    }
+    attrbuf_runs_merge(ab, lo_run, hi_run - lo_run);
+  }
+  else {
+    // replace the whole range with a single run
+    ab->runs[lo_run].attr  = attr;
+    ab->runs[lo_run].count = hi - pos;
+    attrbuf_runs_close(ab, lo_run + 1, hi_run - (lo_run + 1));
+    attrbuf_runs_merge(ab, lo_run, 1);
   }
-  // fill pos to end with attr 
-  for(i = pos; i < end; i++) {
-    ab->attrs[i] = (update ? attr_update_with(ab->attrs[i],attr) : attr);    
-  }  
 }
 
 ic_private void attrbuf_set_at( attrbuf_t* ab, ssize_t pos, ssize_t count, attr_t attr ) {
@@ -257,15 +372,22 @@ ic_private void attrbuf_set_at( attrbuf_t* ab, ssize_t pos, ssize_t count, attr_
 }
 
 ic_private void attrbuf_update_at( attrbuf_t* ab, ssize_t pos, ssize_t count, attr_t attr ) {
-  attrbuf_update_set_at(ab, pos, count, attr, true);  
+  attrbuf_update_set_at(ab, pos, count, attr, true);
 }
 
 ic_private void attrbuf_insert_at( attrbuf_t* ab, ssize_t pos, ssize_t count, attr_t attr ) {
-  if (pos < 0 || pos > ab->count || count <= 0) return;
-  if (!attrbuf_ensure_extra(ab,count)) return;  
-  ic_memmove( ab->attrs + pos + count, ab->attrs + pos, (ab->count - pos)*ssizeof(attr_t) );
+  if (ab == NULL || pos < 0 || pos > ab->count || count <= 0) return;
+  ab->flat_valid = false;
+  if (pos == ab->count) {
+    attrbuf_append_span(ab, attr, count);
+    return;
+  }
+  const ssize_t i = attrbuf_run_split(ab, pos);
+  if (!attrbuf_runs_open(ab, i, 1)) return;
+  ab->runs[i].attr  = attr;
+  ab->runs[i].count = count;
   ab->count += count;
-  attrbuf_set_at( ab, pos, count, attr );
+  attrbuf_runs_merge(ab, i, 1);
 }
 
 
@@ -273,22 +395,56 @@ ic_private void attrbuf_insert_at( attrbuf_t* ab, ssize_t pos, ssize_t count, at
 ic_private ssize_t attrbuf_append_n( stringbuf_t* sb, attrbuf_t* ab, const char* s, ssize_t len, attr_t attr ) {
   if (s == NULL || len == 0) return sbuf_len(sb);
   if (ab != NULL) {
-    if (!attrbuf_ensure_extra(ab,len)) return sbuf_len(sb);
-    attrbuf_set_at(ab, ab->count, len, attr);
+    attrbuf_append_span(ab, attr, len);
   }
   return sbuf_append_n(sb,s,len);
 }
 
 ic_private attr_t attrbuf_attr_at( attrbuf_t* ab, ssize_t pos ) {
-  if (ab==NULL || pos < 0 || pos > ab->count) return attr_none();
-  return ab->attrs[pos];
+  if (ab==NULL || pos < 0 || pos >= ab->count) return attr_none();
+  ssize_t ofs;
+  const ssize_t i = attrbuf_run_find(ab, pos, &ofs);
+  return ab->runs[i].attr;
 }
 
 ic_private void attrbuf_delete_at( attrbuf_t* ab, ssize_t pos, ssize_t count ) {
   if (ab==NULL || pos < 0 || pos > ab->count) return;
   if (pos + count > ab->count) { count = ab->count - pos; }
-  if (count == 0) return;
-  assert(pos + count <= ab->count);
-  ic_memmove( ab->attrs + pos, ab->attrs + pos + count, ab->count - (pos + count) );
+  if (count <= 0) return;
+  ab->flat_valid = false;
+  const ssize_t lo = attrbuf_run_split(ab, pos);
+  const ssize_t hi = attrbuf_run_split(ab, pos + count);
+  attrbuf_runs_close(ab, lo, hi - lo);
   ab->count -= count;
+  attrbuf_runs_merge(ab, lo, 0);
+}
+
+
+//-------------------------------------------------------------
+// Run iteration (for rendering)
+//-------------------------------------------------------------
+
+ic_private void attrbuf_iter_start( const attrbuf_t* ab, ssize_t pos, attrbuf_iter_t* iter ) {
+  iter->ab = ab;
+  iter->run = (ab == NULL ? 0 : ab->run_count);
+  iter->left = 0;
+  if (ab == NULL || pos < 0 || pos >= ab->count) return;
+  ssize_t ofs;
+  iter->run = attrbuf_run_find(ab, pos, &ofs);
+  iter->left = ab->runs[iter->run].count - (pos - ofs);
+}
+
+// get the next run; returns false at the end
+ic_private bool attrbuf_iter_next( attrbuf_iter_t* iter, attr_t* attr, ssize_t* count ) {
+  const attrbuf_t* ab = iter->ab;
+  if (ab == NULL || iter->run >= ab->run_count) return false;
+  if (iter->left <= 0) {
+    iter->run++;
+    if (iter->run >= ab->run_count) return false;
+    iter->left = ab->runs[iter->run].count;
+  }
+  if (attr != NULL)  { *attr = ab->runs[iter->run].attr; }
+  if (count != NULL) { *count = iter->left; }
+  iter->left = 0;
+  return true;
 }
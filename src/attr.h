@@ -64,7 +64,17 @@ ic_private void           attrbuf_set_at( attrbuf_t* ab, ssize_t pos, ssize_t co
 ic_private void           attrbuf_update_at( attrbuf_t* ab, ssize_t pos, ssize_t count, attr_t attr );
 ic_private void           attrbuf_insert_at( attrbuf_t* ab, ssize_t pos, ssize_t count, attr_t attr );
 
-ic_private attr_t         attrbuf_attr_at( attrbuf_t* ab, ssize_t pos );   
+ic_private attr_t         attrbuf_attr_at( attrbuf_t* ab, ssize_t pos );
 ic_private void           attrbuf_delete_at( attrbuf_t* ab, ssize_t pos, ssize_t count );
 
+// iterate the runs of identical attributes (for rendering)
+typedef struct attrbuf_iter_s {
+  const attrbuf_t* ab;
+  ssize_t run;     // current run index
+  ssize_t left;    // bytes left in the current run
+} attrbuf_iter_t;
+
+ic_private void           attrbuf_iter_start( const attrbuf_t* ab, ssize_t pos, attrbuf_iter_t* iter );
+ic_private bool           attrbuf_iter_next( attrbuf_iter_t* iter, attr_t* attr, ssize_t* count );
+
 #endif // IC_ATTR_H
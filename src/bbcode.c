@@ -29,6 +29,16 @@ typedef struct style_s {
   attr_t  attr;  // attribute to apply
 } style_t;
 
+// Hash table of user defined styles (open addressing with linear probing)
+// so style resolution stays O(1) regardless of how many styles an
+// application defines.
+typedef struct styledict_s {
+  style_t* entries;     // `name == NULL` is an empty slot
+  ssize_t  capacity;    // power of two (or 0 if not yet allocated)
+  ssize_t  count;
+  alloc_t* mem;
+} styledict_t;
+
 typedef enum align_e {
   IC_ALIGN_LEFT,
   IC_ALIGN_CENTER,
@@ -58,18 +68,91 @@ struct bbcode_s {
   tag_t*       tags;              // stack of tags; one entry for each open tag
   ssize_t      tags_capacity;
   ssize_t      tags_nesting;   
-  style_t*     styles;            // list of used defined styles
-  ssize_t      styles_capacity;
-  ssize_t      styles_count;
+  styledict_t  styles;            // user defined styles
   term_t*      term;              // terminal
   alloc_t*     mem;               // allocator
   // caches
   stringbuf_t*  out;              // print buffer
   attrbuf_t*    out_attrs;
-  stringbuf_t*  vout;             // vprintf buffer 
+  stringbuf_t*  vout;             // vprintf buffer
+  // pager state (see `bbcode_enable_pager`)
+  bool         pager;            // pause after each screenful when printing?
+  bool         pager_active;     // paging the current print?
+  bool         pager_quit;       // the user quit the pager; discard remaining output
+  ssize_t      pager_rows;       // rows written since the last pause
+  ssize_t      pager_col;        // column width of the current (unterminated) line
 };
 
 
+//-------------------------------------------------------------
+// Style registry
+//-------------------------------------------------------------
+
+static uint32_t styledict_hash( const char* name ) {
+  // FNV-1a
+  uint32_t h = 2166136261U;
+  while (*name != 0) {
+    h = (h ^ (uint8_t)(*name)) * 16777619U;
+    name++;
+  }
+  return h;
+}
+
+static style_t* styledict_find_slot( const styledict_t* dict, const char* name ) {
+  assert(dict->entries != NULL && dict->capacity > 0);
+  ssize_t i = (ssize_t)(styledict_hash(name) & (uint32_t)(dict->capacity - 1));
+  while (true) {
+    style_t* entry = &dict->entries[i];
+    if (entry->name == NULL || strcmp(entry->name,name) == 0) return entry;
+    i = (i + 1) & (dict->capacity - 1);
+  }
+}
+
+static bool styledict_ensure_extra( styledict_t* dict, ssize_t extra ) {
+  if (dict->entries != NULL && 4*(dict->count + extra) <= 3*dict->capacity) return true;  // keep load under 75%
+  ssize_t newcap = (dict->capacity <= 0 ? 32 : 2*dict->capacity);
+  style_t* newentries = mem_zalloc_tp_n( dict->mem, style_t, newcap );
+  if (newentries == NULL) return false;
+  style_t* oldentries = dict->entries;
+  const ssize_t oldcap = dict->capacity;
+  dict->entries = newentries;
+  dict->capacity = newcap;
+  for (ssize_t i = 0; i < oldcap; i++) {
+    if (oldentries[i].name != NULL) {
+      *styledict_find_slot(dict, oldentries[i].name) = oldentries[i];
+    }
+  }
+  mem_free(dict->mem, oldentries);
+  return true;
+}
+
+static void styledict_set( styledict_t* dict, const char* name, attr_t attr ) {
+  if (!styledict_ensure_extra(dict,1)) return;
+  style_t* entry = styledict_find_slot(dict, name);
+  if (entry->name == NULL) {
+    entry->name = mem_strdup( dict->mem, name );
+    if (entry->name == NULL) return;
+    dict->count++;
+  }
+  entry->attr = attr;  // a redefinition overrides the previous style
+}
+
+static const style_t* styledict_get( const styledict_t* dict, const char* name ) {
+  if (dict->entries == NULL) return NULL;
+  const style_t* entry = styledict_find_slot(dict, name);
+  return (entry->name == NULL ? NULL : entry);
+}
+
+static void styledict_done( styledict_t* dict ) {
+  for (ssize_t i = 0; i < dict->capacity; i++) {
+    mem_free(dict->mem, dict->entries[i].name);
+  }
+  mem_free(dict->mem, dict->entries);
+  dict->entries = NULL;
+  dict->capacity = 0;
+  dict->count = 0;
+}
+
 //-------------------------------------------------------------
 // Create, helpers
 //-------------------------------------------------------------
@@ -79,6 +162,7 @@ ic_private bbcode_t* bbcode_new( alloc_t* mem, term_t* term ) {
   if (bb==NULL) return NULL;
   bb->mem = mem;
   bb->term = term;
+  bb->styles.mem = mem;
   bb->out = sbuf_new(mem);
   bb->out_attrs = attrbuf_new(mem);
   bb->vout = sbuf_new(mem);
@@ -86,11 +170,8 @@ ic_private bbcode_t* bbcode_new( alloc_t* mem, term_t* term ) {
 }
 
 ic_private void bbcode_free( bbcode_t* bb ) {
-  for(ssize_t i = 0; i < bb->styles_count; i++) {
-    mem_free(bb->mem, bb->styles[i].name);
-  }
+  styledict_done(&bb->styles);
   mem_free(bb->mem, bb->tags);
-  mem_free(bb->mem, bb->styles);
   sbuf_free(bb->vout);
   sbuf_free(bb->out);
   attrbuf_free(bb->out_attrs);
@@ -98,17 +179,7 @@ ic_private void bbcode_free( bbcode_t* bb ) {
 }
 
 ic_private void bbcode_style_add( bbcode_t* bb, const char* style_name, attr_t attr ) {
-  if (bb->styles_count >= bb->styles_capacity) {
-    ssize_t newlen = bb->styles_capacity + 32;
-    style_t* p = mem_realloc_tp( bb->mem, style_t, bb->styles, newlen );
-    if (p == NULL) return;
-    bb->styles = p;
-    bb->styles_capacity = newlen;
-  }
-  assert(bb->styles_count < bb->styles_capacity);
-  bb->styles[bb->styles_count].name = mem_strdup( bb->mem, style_name );
-  bb->styles[bb->styles_count].attr = attr;
-  bb->styles_count++;
+  styledict_set(&bb->styles, style_name, attr);
 }
 
 static ssize_t bbcode_tag_push( bbcode_t* bb, const tag_t* tag ) {
@@ -404,8 +475,8 @@ static const style_t builtin_styles[] = {
   { NULL, { { IC_COLOR_NONE, IC_NONE, IC_NONE, IC_COLOR_NONE, IC_NONE, IC_NONE } } }
 };
 
-static void attr_update_with_styles( tag_t* tag, const char* attr_name, const char* value, 
-                                             bool usebgcolor, const style_t* styles, ssize_t count ) 
+static void attr_update_with_styles( tag_t* tag, const char* attr_name, const char* value,
+                                             bool usebgcolor, const styledict_t* styles )
 {
   // direct hex color?
   if (attr_name[0] == '#' && (value == NULL || value[0]==0)) {
@@ -418,20 +489,18 @@ static void attr_update_with_styles( tag_t* tag, const char* attr_name, const ch
     if (tag->name != NULL) tag->name = name;
     return;
   }
-  // then check all styles
-  while( count-- > 0 ) {
-    const style_t* style = styles + count;
-    if (strcmp(style->name,attr_name) == 0) {
-      tag->attr = attr_update_with(tag->attr,style->attr);
-      if (tag->name != NULL) tag->name = style->name;
-      return;
-    }    
+  // then check the user defined styles
+  const style_t* style = styledict_get(styles, attr_name);
+  if (style != NULL) {
+    tag->attr = attr_update_with(tag->attr,style->attr);
+    if (tag->name != NULL) tag->name = style->name;
+    return;
   }
   // check builtin styles; todo: binary search?
-  for( const style_t* style = builtin_styles; style->name != NULL; style++) {
-    if (strcmp(style->name,attr_name) == 0) {
-      tag->attr = attr_update_with(tag->attr,style->attr);
-      if (tag->name != NULL) tag->name = style->name;
+  for( const style_t* bstyle = builtin_styles; bstyle->name != NULL; bstyle++) {
+    if (strcmp(bstyle->name,attr_name) == 0) {
+      tag->attr = attr_update_with(tag->attr,bstyle->attr);
+      if (tag->name != NULL) tag->name = bstyle->name;
       return;
     }
   }
@@ -465,7 +534,7 @@ static void attr_update_with_styles( tag_t* tag, const char* attr_name, const ch
 ic_private attr_t bbcode_style( bbcode_t* bb, const char* style_name ) {
   tag_t tag;
   tag_init(&tag);
-  attr_update_with_styles( &tag, style_name, NULL, false, bb->styles, bb->styles_count );
+  attr_update_with_styles( &tag, style_name, NULL, false, &bb->styles );
   return tag.attr;
 }
 
@@ -543,7 +612,7 @@ ic_private const char* parse_value(const char* s, const char** start, const char
   return s;  
 }
 
-ic_private const char* parse_tag_value( tag_t* tag, char* idbuf, const char* s, const style_t* styles, ssize_t scount ) {
+ic_private const char* parse_tag_value( tag_t* tag, char* idbuf, const char* s, const styledict_t* styles ) {
   // parse: \s*[\w-]+\s*(=\s*<value>)
   bool usebgcolor = false;
   const char* id = s;
@@ -579,24 +648,24 @@ ic_private const char* parse_tag_value( tag_t* tag, char* idbuf, const char* s,
   ic_strncpy( valbuf, 128, val, valend - val);
   ic_str_tolower(idbuf);
   ic_str_tolower(valbuf);
-  attr_update_with_styles( tag, idbuf, valbuf, usebgcolor, styles, scount );  
+  attr_update_with_styles( tag, idbuf, valbuf, usebgcolor, styles );
   return s;
 }
 
-static const char* parse_tag_values( tag_t* tag, char* idbuf, const char* s, const style_t* styles, ssize_t scount ) {
+static const char* parse_tag_values( tag_t* tag, char* idbuf, const char* s, const styledict_t* styles ) {
   s = parse_skip_white(s);  
   idbuf[0] = 0;
   ssize_t count = 0;
   while( *s != 0 && *s != ']') {
     char idbuf_next[128];
-    s = parse_tag_value(tag, (count==0 ? idbuf : idbuf_next), s, styles, scount);
+    s = parse_tag_value(tag, (count==0 ? idbuf : idbuf_next), s, styles);
     count++;
   }
   if (*s == ']') { s++; }
   return s;
 }
 
-static const char* parse_tag( tag_t* tag, char* idbuf, bool* open, bool* pre, const char* s, const style_t* styles, ssize_t scount ) {
+static const char* parse_tag( tag_t* tag, char* idbuf, bool* open, bool* pre, const char* s, const styledict_t* styles ) {
   *open = true;
   *pre = false;
   if (*s != '[') return s;
@@ -609,7 +678,7 @@ static const char* parse_tag( tag_t* tag, char* idbuf, bool* open, bool* pre, co
     *open = false; 
     s = parse_skip_white(s+1); 
   };
-  s = parse_tag_values( tag, idbuf, s, styles, scount);
+  s = parse_tag_values( tag, idbuf, s, styles);
   return s;
 }
 
@@ -622,7 +691,7 @@ static void bbcode_parse_tag_content( bbcode_t* bb, const char* s, tag_t* tag )
   tag_init(tag);
   if (s != NULL) { 
     char idbuf[128];
-    parse_tag_values(tag, idbuf, s, bb->styles, bb->styles_count);
+    parse_tag_values(tag, idbuf, s, &bb->styles);
   }
 }
 
@@ -723,7 +792,7 @@ ic_private ssize_t bbcode_process_tag( bbcode_t* bb, const char* s, const ssize_
   bool open = true;
   bool ispre = false;
   char idbuf[128];
-  const char* end = parse_tag( &tag, idbuf, &open, &ispre, s, bb->styles, bb->styles_count ); // todo: styles
+  const char* end = parse_tag( &tag, idbuf, &open, &ispre, s, &bb->styles );
   assert(end > s);
   if (open) {
     if (!ispre) {
@@ -762,12 +831,14 @@ ic_private ssize_t bbcode_process_tag( bbcode_t* bb, const char* s, const ssize_
   return (end - s);
 }
 
-ic_private void bbcode_append( bbcode_t* bb, const char* s, stringbuf_t* out, attrbuf_t* attr_out ) {
-  if (bb == NULL || s == NULL) return;
-  attr_t attr = attr_none();
-  const ssize_t base = bb->tags_nesting; // base; will not be popped
+// Process markup until at least `limit` bytes are consumed (always ending at a
+// token boundary) or the string ends; the current attribute and the open tag
+// stack carry over between calls so long output can be processed in bounded
+// chunks. Returns the number of bytes consumed.
+static ssize_t bbcode_append_chunk( bbcode_t* bb, const char* s, ssize_t limit, ssize_t base,
+                                     attr_t* attr, stringbuf_t* out, attrbuf_t* attr_out ) {
   ssize_t i = 0;
-  while( s[i] != 0 ) {
+  while( s[i] != 0 && i < limit ) {
     // handle no tags in bulk
     ssize_t nobb = 0;
     char c;
@@ -778,23 +849,39 @@ ic_private void bbcode_append( bbcode_t* bb, const char* s, stringbuf_t* out, at
       }
       nobb++;
     }
-    if (nobb > 0) { attrbuf_append_n(out, attr_out, s+i, nobb, attr); }
+    if (i + nobb > limit) {
+      // cap the run at the chunk limit; back up so a following flush cannot
+      // interleave attribute codes inside a utf-8 sequence or an 'ESC[' pair
+      nobb = limit - i;
+      while( nobb > 0 && ((uint8_t)s[i+nobb] & 0xC0) == 0x80 ) { nobb--; }
+      if (nobb > 0 && s[i+nobb-1] == '\x1B' && s[i+nobb] == '[') { nobb--; }
+      if (nobb == 0) { nobb = 1; }  // always make progress
+    }
+    if (nobb > 0) { attrbuf_append_n(out, attr_out, s+i, nobb, *attr); }
     i += nobb;
     // tag
     if (s[i] == '[') {
-      i += bbcode_process_tag(bb, s+i, base, out, attr_out, &attr);
+      i += bbcode_process_tag(bb, s+i, base, out, attr_out, attr);
     }
     else if (s[i] == '\\') {
       if (s[i+1] == '\\' || s[i+1] == '[') {
-        attrbuf_append_n(out, attr_out, s+i+1, 1, attr); // escape '\[' and '\\' 
+        attrbuf_append_n(out, attr_out, s+i+1, 1, *attr); // escape '\[' and '\\'
         i += 2;
       }
       else {
-        attrbuf_append_n(out, attr_out, s+i, 1, attr);  // pass '\\' as is
+        attrbuf_append_n(out, attr_out, s+i, 1, *attr);  // pass '\\' as is
         i++;
       }
     }
   }
+  return i;
+}
+
+ic_private void bbcode_append( bbcode_t* bb, const char* s, stringbuf_t* out, attrbuf_t* attr_out ) {
+  if (bb == NULL || s == NULL) return;
+  attr_t attr = attr_none();
+  const ssize_t base = bb->tags_nesting; // base; will not be popped
+  bbcode_append_chunk( bb, s, ic_strlen(s), base, &attr, out, attr_out );
   // pop unclosed openings
   assert(bb->tags_nesting >= base);
   while( bb->tags_nesting > base ) {
@@ -802,13 +889,122 @@ ic_private void bbcode_append( bbcode_t* bb, const char* s, stringbuf_t* out, at
   };
 }
 
+//---------------------------------------------------------
+// Pager
+//---------------------------------------------------------
+
+ic_private bool bbcode_enable_pager( bbcode_t* bb, bool enable ) {
+  bool prev = bb->pager;
+  bb->pager = enable;
+  return prev;
+}
+
+// a screenful was written: pause until a key is pressed.
+// <space> advances a page, <enter> a single row, and 'q' (or esc) quits.
+static void bbcode_pager_pause( bbcode_t* bb ) {
+  tty_t* tty = term_get_tty(bb->term);
+  assert(tty != NULL);
+  const attr_t attr = term_get_attr(bb->term);
+  term_attr_reset(bb->term);
+  term_reverse(bb->term,true);
+  term_write(bb->term, "--more--");
+  term_reverse(bb->term,false);
+  term_flush(bb->term);
+  code_t c = KEY_NONE;
+  if (tty_start_raw(tty)) {
+    c = tty_read(tty);
+    tty_end_raw(tty);
+  }
+  term_clear_line(bb->term);
+  term_set_attr(bb->term, attr);
+  if (c == KEY_NONE) {
+    bb->pager_active = false;  // could not read a key; write the rest without pausing
+  }
+  else if (c == 'q' || c == 'Q' || c == KEY_ESC || c == KEY_CTRL_C || c == KEY_CTRL_D) {
+    bb->pager_quit = true;
+  }
+  else if (c == KEY_ENTER || c == KEY_LINEFEED) {
+    bb->pager_rows = term_get_height(bb->term) - 2;  // pause again after one more row
+  }
+  else {
+    bb->pager_rows = 0;  // a further screenful
+  }
+}
+
+// write the pending output a line at a time, pausing at each full screen
+static void bbcode_pager_write( bbcode_t* bb ) {
+  const char*   s     = sbuf_string(bb->out);
+  const ssize_t len   = sbuf_len(bb->out);
+  const ssize_t termw = term_get_width(bb->term);
+  const ssize_t termh = term_get_height(bb->term);
+  ssize_t pos = 0;
+  while( pos < len && !bb->pager_quit ) {
+    const char*   nl   = strchr(s + pos, '\n');
+    const ssize_t eol  = (nl == NULL ? len : (nl - s));       // up to the newline
+    const ssize_t end  = (nl == NULL ? len : eol + 1);        // including the newline
+    term_write_formatted_runs(bb->term, s + pos, bb->out_attrs, pos, end - pos);
+    bb->pager_col += str_column_width_n(s + pos, eol - pos);
+    if (nl != NULL) {
+      // count the terminal rows the line occupied (including hard wrapping)
+      bb->pager_rows += 1 + (termw > 0 && bb->pager_col > 0 ? (bb->pager_col - 1)/termw : 0);
+      bb->pager_col = 0;
+      if (bb->pager_active && bb->pager_rows >= termh-1) { bbcode_pager_pause(bb); }
+    }
+    pos = end;
+  }
+}
+
+// write (or discard) the pending output and clear the print buffer
+static void bbcode_output_flush( bbcode_t* bb ) {
+  if (sbuf_len(bb->out) > 0 && !bb->pager_quit) {
+    if (bb->pager_active) {
+      bbcode_pager_write(bb);
+    }
+    else {
+      term_write_formatted_runs( bb->term, sbuf_string(bb->out), bb->out_attrs, 0, sbuf_len(bb->out) );
+    }
+  }
+  attrbuf_clear(bb->out_attrs);
+  sbuf_clear(bb->out);
+}
+
+// is there an open width-restricted tag? (its close may still rewrite the pending output)
+static bool bbcode_tags_have_width( const bbcode_t* bb, ssize_t base ) {
+  for( ssize_t i = base; i < bb->tags_nesting; i++ ) {
+    if (bb->tags[i].width.w > 0) return true;
+  }
+  return false;
+}
+
+// process markup in bounded chunks and write each chunk as soon as it is
+// complete: first output appears before the whole string is formatted and
+// peak memory stays independent of the output size.
+#define IC_BBCODE_CHUNK_SIZE  (4*1024)
+
 ic_private void bbcode_print( bbcode_t* bb, const char* s ) {
   if (bb->out == NULL || bb->out_attrs == NULL || s == NULL) return;
   assert(sbuf_len(bb->out) == 0 && attrbuf_len(bb->out_attrs) == 0);
-  bbcode_append( bb, s, bb->out, bb->out_attrs );
-  term_write_formatted( bb->term, sbuf_string(bb->out), attrbuf_attrs(bb->out_attrs,sbuf_len(bb->out)) );
-  attrbuf_clear(bb->out_attrs);
-  sbuf_clear(bb->out);
+  const ssize_t base = bb->tags_nesting; // base; will not be popped
+  attr_t attr = attr_none();
+  bb->pager_active = (bb->pager && term_is_interactive(bb->term) && term_get_tty(bb->term) != NULL);
+  bb->pager_quit = false;
+  bb->pager_rows = 0;
+  bb->pager_col  = 0;
+  ssize_t i = 0;
+  while( s[i] != 0 ) {
+    i += bbcode_append_chunk(bb, s+i, IC_BBCODE_CHUNK_SIZE, base, &attr, bb->out, bb->out_attrs);
+    // an open width-restricted tag may still rewrite the pending output; keep buffering until it closes
+    if (!bbcode_tags_have_width(bb, base)) {
+      bbcode_output_flush(bb);
+    }
+  }
+  // pop unclosed openings
+  assert(bb->tags_nesting >= base);
+  while( bb->tags_nesting > base ) {
+    bbcode_tag_pop(bb,NULL);
+  };
+  bbcode_output_flush(bb);
+  bb->pager_active = false;
 }
 
 ic_private void bbcode_println( bbcode_t* bb, const char* s ) {
@@ -816,6 +1012,115 @@ ic_private void bbcode_println( bbcode_t* bb, const char* s ) {
   term_writeln(bb->term, "");
 }
 
+//---------------------------------------------------------
+// Templates: compile markup once into resolved (text,attr)
+// spans so repeated printing needs no parsing and no
+// style-name lookups.
+//---------------------------------------------------------
+
+#define BBCODE_SLOT_CHAR  '\x01'   // internal marker for a `%s` substitution slot
+
+struct bbtemplate_s {
+  alloc_t*   mem;
+  char*      text;        // fully expanded text (slot markers removed)
+  ssize_t    len;
+  attrbuf_t* attrs;       // resolved attributes for `text`
+  ssize_t*   slot_pos;    // byte position in `text` where each argument is inserted
+  attr_t*    slot_attr;   // attribute each argument is printed with
+  ssize_t    slot_count;
+};
+
+ic_private bbtemplate_t* bbcode_template_new( bbcode_t* bb, const char* s ) {
+  if (bb == NULL || s == NULL) return NULL;
+  // mark the `%s` substitution slots with a sentinel byte
+  stringbuf_t* src = sbuf_new(bb->mem);
+  if (src == NULL) return NULL;
+  ssize_t slots = 0;
+  for (ssize_t i = 0; s[i] != 0; i++) {
+    if (s[i] == '%' && s[i+1] == 's')      { sbuf_append_char(src, BBCODE_SLOT_CHAR); slots++; i++; }
+    else if (s[i] == '%' && s[i+1] == '%') { sbuf_append_char(src, '%'); i++; }
+    else if (s[i] != BBCODE_SLOT_CHAR)     { sbuf_append_char(src, s[i]); }
+  }
+  // parse the markup once
+  stringbuf_t* out   = sbuf_new(bb->mem);
+  attrbuf_t*   attrs = attrbuf_new(bb->mem);
+  bbcode_append(bb, sbuf_string(src), out, attrs);
+  sbuf_free(src);
+  // and record the expanded text, its attributes, and the slot positions
+  bbtemplate_t* tpl = mem_zalloc_tp(bb->mem, bbtemplate_t);
+  if (tpl == NULL) { sbuf_free(out); attrbuf_free(attrs); return NULL; }
+  tpl->mem = bb->mem;
+  tpl->slot_count = slots;
+  if (slots > 0) {
+    tpl->slot_pos  = mem_zalloc_tp_n(bb->mem, ssize_t, slots);
+    tpl->slot_attr = mem_zalloc_tp_n(bb->mem, attr_t, slots);
+  }
+  stringbuf_t* text = sbuf_new(bb->mem);
+  tpl->attrs = attrbuf_new(bb->mem);
+  ssize_t slot = 0;
+  const ssize_t outlen = sbuf_len(out);
+  for (ssize_t i = 0; i < outlen; i++) {
+    const char c = sbuf_char_at(out, i);
+    if (c == BBCODE_SLOT_CHAR) {
+      if (slot < slots && tpl->slot_pos != NULL) {
+        tpl->slot_pos[slot]  = sbuf_len(text);
+        tpl->slot_attr[slot] = attrbuf_attr_at(attrs, i);
+        slot++;
+      }
+    }
+    else {
+      attrbuf_append_n(text, tpl->attrs, &c, 1, attrbuf_attr_at(attrs, i));
+    }
+  }
+  tpl->len  = sbuf_len(text);
+  tpl->text = sbuf_free_dup(text);
+  sbuf_free(out);
+  attrbuf_free(attrs);
+  return tpl;
+}
+
+ic_private void bbcode_template_free( bbtemplate_t* tpl ) {
+  if (tpl == NULL) return;
+  alloc_t* mem = tpl->mem;
+  attrbuf_free(tpl->attrs);
+  mem_free(mem, tpl->text);
+  mem_free(mem, tpl->slot_pos);
+  mem_free(mem, tpl->slot_attr);
+  mem_free(mem, tpl);
+}
+
+ic_private void bbcode_template_print( bbcode_t* bb, const bbtemplate_t* tpl, const char** args, ssize_t arg_count ) {
+  if (bb == NULL || tpl == NULL || bb->out == NULL || bb->out_attrs == NULL) return;
+  assert(sbuf_len(bb->out) == 0 && attrbuf_len(bb->out_attrs) == 0);
+  ssize_t prev = 0;
+  for (ssize_t slot = 0; slot <= tpl->slot_count; slot++) {
+    const ssize_t end = (slot < tpl->slot_count ? tpl->slot_pos[slot] : tpl->len);
+    // copy the text span run by run (no parsing, no style lookups)
+    attrbuf_iter_t iter;
+    attrbuf_iter_start(tpl->attrs, prev, &iter);
+    ssize_t i = prev;
+    attr_t attr;
+    ssize_t n;
+    while (i < end && attrbuf_iter_next(&iter, &attr, &n)) {
+      if (n > end - i) { n = end - i; }
+      attrbuf_append_n(bb->out, bb->out_attrs, tpl->text + i, n, attr);
+      i += n;
+    }
+    if (i < end) { attrbuf_append_n(bb->out, bb->out_attrs, tpl->text + i, end - i, attr_none()); }
+    // and substitute the argument with the attribute at the slot
+    if (slot < tpl->slot_count) {
+      const char* arg = (args != NULL && slot < arg_count ? args[slot] : NULL);
+      if (arg != NULL) {
+        attrbuf_append_n(bb->out, bb->out_attrs, arg, ic_strlen(arg), tpl->slot_attr[slot]);
+      }
+    }
+    prev = end;
+  }
+  term_write_formatted_runs(bb->term, sbuf_string(bb->out), bb->out_attrs, 0, sbuf_len(bb->out));
+  attrbuf_clear(bb->out_attrs);
+  sbuf_clear(bb->out);
+}
+
 ic_private void bbcode_vprintf( bbcode_t* bb, const char* fmt, va_list args  ) {
   if (bb->vout == NULL || fmt == NULL) return;
   assert(sbuf_len(bb->vout) == 0);
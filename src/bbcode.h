@@ -24,6 +24,8 @@ ic_private void bbcode_style_open( bbcode_t* bb, const char* fmt );
 ic_private void bbcode_style_close( bbcode_t* bb, const char* fmt );
 ic_private attr_t bbcode_style( bbcode_t* bb, const char* style_name );
 
+ic_private bool bbcode_enable_pager( bbcode_t* bb, bool enable );
+
 ic_private void bbcode_print( bbcode_t* bb, const char* s );
 ic_private void bbcode_println( bbcode_t* bb, const char* s );
 ic_private void bbcode_printf( bbcode_t* bb, const char* fmt, ... );
@@ -31,6 +33,14 @@ ic_private void bbcode_vprintf( bbcode_t* bb, const char* fmt, va_list args );
 
 ic_private ssize_t bbcode_column_width( bbcode_t* bb, const char* s );
 
+// precompiled markup template (parsed once, printed many times)
+struct bbtemplate_s;
+typedef struct bbtemplate_s bbtemplate_t;
+
+ic_private bbtemplate_t* bbcode_template_new( bbcode_t* bb, const char* s );
+ic_private void bbcode_template_free( bbtemplate_t* tpl );
+ic_private void bbcode_template_print( bbcode_t* bb, const bbtemplate_t* tpl, const char** args, ssize_t arg_count );
+
 // allows `attr_out == NULL`.
 ic_private void bbcode_append( bbcode_t* bb, const char* s, stringbuf_t* out, attrbuf_t* attr_out );
 
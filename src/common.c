@@ -12,6 +12,36 @@
 #include "common.h"
 
 
+//-------------------------------------------------------------
+// Instrumentation counters (only when compiled with IC_STATS)
+//-------------------------------------------------------------
+
+#if defined(IC_STATS)
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+ic_stats_t ic_stats;
+
+ic_private uint64_t ic_stats_now(void) {
+  #if defined(_WIN32)
+  LARGE_INTEGER freq; LARGE_INTEGER count;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  return (uint64_t)((1000000000.0 * (double)count.QuadPart) / (double)freq.QuadPart);
+  #else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+  #endif
+}
+
+#endif
+
+
 //-------------------------------------------------------------
 // String wrappers for ssize_t
 //-------------------------------------------------------------
@@ -304,11 +334,131 @@ ic_private void debug_msg(const char* fmt, ...) {
 #endif
 
 
+//-------------------------------------------------------------
+// Arena allocation
+// Bump allocation from pages with an `alloc_t` view so all the
+// mem_* functions (and everything built on them) can allocate
+// transiently; the arena resets in O(1) and keeps its pages for
+// reuse. Each allocation is prefixed with its size so realloc
+// can copy (or extend the most recent allocation in place).
+//-------------------------------------------------------------
+
+#define IC_ARENA_PAGE_SIZE  (16*1024)
+
+typedef struct arenapage_s {
+  struct arenapage_s* next;
+  ssize_t size;               // data size
+  ssize_t used;
+  // data follows the header
+} arenapage_t;
+
+struct arena_s {
+  alloc_t      alloc;         // `alloc_t` view of this arena (alloc.arena points back here)
+  alloc_t*     mem;           // backing allocator for the pages
+  arenapage_t* pages;
+  arenapage_t* current;       // page that is bump-allocated from
+  void*        last;          // most recent allocation (for in-place realloc and free)
+};
+
+static char* arenapage_data( arenapage_t* page ) {
+  return (char*)(page + 1);
+}
+
+ic_private arena_t* arena_new( alloc_t* mem ) {
+  arena_t* arena = mem_zalloc_tp(mem, arena_t);
+  if (arena == NULL) return NULL;
+  arena->mem = mem;
+  arena->alloc = *mem;
+  arena->alloc.arena = arena;
+  return arena;
+}
+
+ic_private alloc_t* arena_allocator( arena_t* arena ) {
+  return &arena->alloc;
+}
+
+ic_private void arena_reset( arena_t* arena ) {
+  if (arena == NULL) return;
+  for (arenapage_t* page = arena->pages; page != NULL; page = page->next) {
+    page->used = 0;
+  }
+  arena->current = arena->pages;
+  arena->last = NULL;
+}
+
+ic_private void arena_free( arena_t* arena ) {
+  if (arena == NULL) return;
+  arenapage_t* page = arena->pages;
+  while (page != NULL) {
+    arenapage_t* next = page->next;
+    mem_free(arena->mem, page);
+    page = next;
+  }
+  mem_free(arena->mem, arena);
+}
+
+static void* arena_malloc( arena_t* arena, ssize_t sz ) {
+  if (sz < 0) return NULL;
+  const ssize_t needed = ssizeof(ssize_t) + ((sz + 7) & ~((ssize_t)7));
+  // find room, advancing through (reset) pages before allocating a new one
+  while (arena->current != NULL && arena->current->used + needed > arena->current->size) {
+    arena->current = arena->current->next;
+  }
+  if (arena->current == NULL) {
+    const ssize_t psize = (needed > IC_ARENA_PAGE_SIZE ? needed : IC_ARENA_PAGE_SIZE);
+    arenapage_t* page = (arenapage_t*)mem_malloc(arena->mem, ssizeof(arenapage_t) + psize);
+    if (page == NULL) return NULL;
+    page->size = psize;
+    page->used = 0;
+    page->next = arena->pages;
+    arena->pages = page;
+    arena->current = page;
+  }
+  char* p = arenapage_data(arena->current) + arena->current->used;
+  arena->current->used += needed;
+  *((ssize_t*)p) = sz;
+  arena->last = p + ssizeof(ssize_t);
+  return arena->last;
+}
+
+static ssize_t arena_size_of( const void* p ) {
+  return *((const ssize_t*)p - 1);
+}
+
+static void arena_free_at( arena_t* arena, const void* p ) {
+  if (p == NULL || p != arena->last) return;  // only the most recent allocation can be reclaimed
+  char* block = (char*)p - ssizeof(ssize_t);
+  arena->current->used = block - arenapage_data(arena->current);
+  arena->last = NULL;
+}
+
+static void* arena_realloc( arena_t* arena, void* p, ssize_t newsz ) {
+  if (p == NULL) return arena_malloc(arena, newsz);
+  const ssize_t sz = arena_size_of(p);
+  if (newsz <= sz) return p;
+  if (p == arena->last) {
+    // try to extend the most recent allocation in place
+    char* block = (char*)p - ssizeof(ssize_t);
+    const ssize_t ofs = block - arenapage_data(arena->current);
+    const ssize_t needed = ssizeof(ssize_t) + ((newsz + 7) & ~((ssize_t)7));
+    if (ofs + needed <= arena->current->size) {
+      arena->current->used = ofs + needed;
+      *((ssize_t*)block) = newsz;
+      return p;
+    }
+  }
+  void* newp = arena_malloc(arena, newsz);
+  if (newp == NULL) return NULL;
+  ic_memcpy(newp, p, sz);
+  return newp;
+}
+
 //-------------------------------------------------------------
 // Allocation
 //-------------------------------------------------------------
 
 ic_private void* mem_malloc(alloc_t* mem, ssize_t sz) {
+  if (mem->arena != NULL) return arena_malloc(mem->arena, sz);
   return mem->malloc(to_size_t(sz));
 }
 
@@ -319,10 +469,12 @@ ic_private void* mem_zalloc(alloc_t* mem, ssize_t sz) {
 }
 
 ic_private void* mem_realloc(alloc_t* mem, void* p, ssize_t newsz) {
+  if (mem->arena != NULL) return arena_realloc(mem->arena, p, newsz);
   return mem->realloc(p, to_size_t(newsz));
 }
 
 ic_private void mem_free(alloc_t* mem, const void* p) {
+  if (mem->arena != NULL) { arena_free_at(mem->arena, p); return; }
   mem->free((void*)p);
 }
 
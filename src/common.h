@@ -42,6 +42,25 @@
 #define ic_unused(x)    (void)(x)
 
 
+//-------------------------------------------------------------
+// Instrumentation counters (see `ic_get_stats`); compiled out
+// entirely unless IC_STATS is defined.
+//-------------------------------------------------------------
+
+#if defined(IC_STATS)
+extern ic_stats_t ic_stats;
+ic_private uint64_t ic_stats_now(void);   // monotonic nanoseconds
+#define ic_stats_count(field,n)   (ic_stats.field += (uint64_t)(n))
+#define ic_stats_timed_begin()    const uint64_t ic__stats_t0 = ic_stats_now()
+#define ic_stats_timed_end(cnt,nsecs) \
+          (ic_stats.cnt++, ic_stats.nsecs += (ic_stats_now() - ic__stats_t0))
+#else
+#define ic_stats_count(field,n)       (void)(0)
+#define ic_stats_timed_begin()        (void)(0)
+#define ic_stats_timed_end(cnt,nsecs) (void)(0)
+#endif
+
+
 //-------------------------------------------------------------
 // ssize_t
 //-------------------------------------------------------------
@@ -155,21 +174,31 @@ ic_private void debug_msg( const char* fmt, ... );
 
 //-------------------------------------------------------------
 // Abstract environment
+// (the opaque `ic_env_t` handle is declared in `isocline.h`)
 //-------------------------------------------------------------
-struct ic_env_s;
-typedef struct ic_env_s ic_env_t;
 
 
 //-------------------------------------------------------------
 // Allocation
 //-------------------------------------------------------------
 
+struct arena_s;
+typedef struct arena_s arena_t;
+
 typedef struct alloc_s {
   ic_malloc_fun_t*  malloc;
   ic_realloc_fun_t* realloc;
   ic_free_fun_t*    free;
+  arena_t*          arena;    // if non-NULL, allocations are bump-allocated from this arena
 } alloc_t;
 
+// Arena allocator for transient allocations: bump allocation from pages,
+// `free` is (mostly) a no-op, and the whole arena resets in O(1) while
+// retaining its pages for reuse.
+ic_private arena_t* arena_new( alloc_t* mem );            // `mem` provides the pages
+ic_private void     arena_free( arena_t* arena );         // release all pages
+ic_private void     arena_reset( arena_t* arena );        // free all allocations at once (pages are kept)
+ic_private alloc_t* arena_allocator( arena_t* arena );    // the `alloc_t` view of the arena
 
 ic_private void* mem_malloc( alloc_t* mem, ssize_t sz );
 ic_private void* mem_zalloc( alloc_t* mem, ssize_t sz );
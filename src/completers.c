@@ -383,6 +383,12 @@ static bool os_is_dir(const char* cpath) {
   return ((st.st_mode & _S_IFDIR) != 0);
 }
 
+static time_t os_get_mtime(const char* cpath) {
+  struct _stat64 st = { 0 };
+  if (_stat64(cpath, &st) != 0) return 0;
+  return (time_t)st.st_mtime;
+}
+
 static file_type_t os_get_filetype(const char* cpath) {
   struct _stat64 st = { 0 };
   _stat64(cpath, &st);
@@ -444,6 +450,13 @@ static bool os_is_dir(const char* cpath) {
   return (S_ISDIR(st.st_mode));
 }
 
+static time_t os_get_mtime(const char* cpath) {
+  struct stat st;
+  memset(&st, 0, sizeof(st));
+  if (stat(cpath, &st) != 0) return 0;
+  return st.st_mtime;
+}
+
 static file_type_t os_get_filetype(const char* cpath) {
   struct stat st;
   memset(&st, 0, sizeof(st));
@@ -512,7 +525,120 @@ ic_private char ic_dirsep(void) {
 
 
 //-------------------------------------------------------------
-// File completion 
+// Directory listing cache
+// A tab in a large directory (10k+ entries over NFS) used to
+// re-read the directory and stat every entry on each press.
+// Cache the last few listings keyed by (path, mtime): the
+// directory is read once per modification, and the two stat
+// calls per entry (file type and is-directory) run lazily --
+// only for entries that actually match the typed prefix -- and
+// are remembered across completion requests. A scan that is
+// cancelled by a keystroke (see `completions_enable_cancel_on_input`)
+// leaves the already-stated entries cached for the next tab.
+//-------------------------------------------------------------
+
+#define IC_DIRCACHE_DIRS  (8)   // keep the last 8 directory listings
+
+typedef struct dircache_entry_s {
+  const char* name;
+  file_type_t ft;
+  bool        isdir;
+  bool        known;    // `ft` and `isdir` determined?
+} dircache_entry_t;
+
+typedef struct dircache_dir_s {
+  const char* path;     // the directory (or NULL for an empty slot)
+  time_t      mtime;    // modification time at scan; a mismatch triggers a rescan
+  dircache_entry_t* entries;
+  ssize_t     count;
+  ssize_t     capacity;
+  ssize_t     used;     // lru stamp
+} dircache_dir_t;
+
+struct dircache_s {
+  alloc_t*       mem;
+  dircache_dir_t dirs[IC_DIRCACHE_DIRS];
+  ssize_t        clock;
+};
+typedef struct dircache_s dircache_t;
+
+static void dircache_dir_clear( dircache_t* dc, dircache_dir_t* dir ) {
+  for (ssize_t i = 0; i < dir->count; i++) {
+    mem_free(dc->mem, dir->entries[i].name);
+  }
+  mem_free(dc->mem, dir->entries);
+  mem_free(dc->mem, dir->path);
+  memset(dir, 0, sizeof(*dir));
+}
+
+ic_private void dircache_free( struct dircache_s* dc ) {
+  if (dc == NULL) return;
+  for (ssize_t i = 0; i < IC_DIRCACHE_DIRS; i++) {
+    dircache_dir_clear(dc, &dc->dirs[i]);
+  }
+  mem_free(dc->mem, dc);
+}
+
+static bool dircache_push( dircache_t* dc, dircache_dir_t* dir, const char* name ) {
+  if (dir->count >= dir->capacity) {
+    const ssize_t newcap = (dir->capacity <= 0 ? 64 : 2*dir->capacity);
+    dircache_entry_t* p = mem_realloc_tp(dc->mem, dircache_entry_t, dir->entries, newcap);
+    if (p == NULL) return false;
+    dir->entries = p;
+    dir->capacity = newcap;
+  }
+  dircache_entry_t* e = &dir->entries[dir->count];
+  memset(e, 0, sizeof(*e));
+  e->name = mem_strdup(dc->mem, name);
+  if (e->name == NULL) return false;
+  dir->count++;
+  return true;
+}
+
+// return the (freshly scanned or cached) listing of `path`; never NULL on success
+static dircache_dir_t* dircache_scan( ic_env_t* env, const char* path ) {
+  if (env->dircache == NULL) {
+    env->dircache = mem_zalloc_tp(env->mem, dircache_t);
+    if (env->dircache == NULL) return NULL;
+    env->dircache->mem = env->mem;
+  }
+  dircache_t* dc = env->dircache;
+  const time_t mtime = os_get_mtime(path);
+  // find the directory, or the least recently used slot to evict
+  dircache_dir_t* dir = NULL;
+  dircache_dir_t* lru = &dc->dirs[0];
+  for (ssize_t i = 0; i < IC_DIRCACHE_DIRS; i++) {
+    dircache_dir_t* d = &dc->dirs[i];
+    if (d->path != NULL && strcmp(d->path, path) == 0) { dir = d; break; }
+    if (d->used < lru->used) { lru = d; }
+  }
+  if (dir != NULL && dir->mtime == mtime) {
+    dir->used = ++dc->clock;  // cache hit
+    return dir;
+  }
+  if (dir == NULL) { dir = lru; }
+  // (re)scan: read the names only; file types are determined lazily
+  dircache_dir_clear(dc, dir);
+  dir->path  = mem_strdup(dc->mem, path);
+  if (dir->path == NULL) return NULL;
+  dir->mtime = mtime;
+  dir->used  = ++dc->clock;
+  dir_cursor d = 0;
+  dir_entry entry;
+  if (os_findfirst(env->mem, path, &d, &entry)) {
+    do {
+      const char* name = os_direntry_name(&entry);
+      if (name != NULL && strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
+        if (!dircache_push(dc, dir, name)) break;
+      }
+    } while (os_findnext(d, &entry));
+    os_findclose(d);
+  }
+  return dir;
+}
+
+//-------------------------------------------------------------
+// File completion
 //-------------------------------------------------------------
 
 static bool ends_with_n(const char* name, ssize_t name_len, const char* ending, ssize_t len) {
@@ -553,41 +679,37 @@ static bool filename_complete_indir( ic_completion_env_t* cenv, stringbuf_t* dir
                                        const char* base_prefix, 
                                         char dir_sep, const char* extensions ) 
 {
-  dir_cursor d = 0;
-  dir_entry entry;
   bool cont = true;
-  if (os_findfirst(cenv->env->mem, sbuf_string(dir), &d, &entry)) {
-    do {
-      const char* name = os_direntry_name(&entry);
-      if (name != NULL && strcmp(name, ".") != 0 && strcmp(name, "..") != 0 && 
-          ic_istarts_with(name, base_prefix))
-      {
-        // possible match, first check if it is a directory
-        file_type_t ft;
-        bool isdir;
-        const ssize_t plen = sbuf_len(dir_prefix);
-        sbuf_append(dir_prefix, name);
-        { // check directory and potentially add a dirsep to the dir_prefix
-          const ssize_t dlen = sbuf_len(dir);
-          sbuf_append_char(dir,ic_dirsep());
-          sbuf_append(dir,name);
-          ft = os_get_filetype(sbuf_string(dir));
-          isdir = os_is_dir(sbuf_string(dir));
-          if (isdir && dir_sep != 0) {
-            sbuf_append_char(dir_prefix,dir_sep); 
-          }
-          sbuf_delete_from(dir,dlen);  // restore dir
-        }
-        if (isdir || match_extension(name, extensions)) {
-          // add completion
-          sbuf_clear(display);
-          ls_colorize(cenv->env->no_lscolors, display, ft, name, NULL, (isdir ? dir_sep : 0));
-          cont = ic_add_completion_ex(cenv, sbuf_string(dir_prefix), sbuf_string(display), NULL);
-        }
-        sbuf_delete_from( dir_prefix, plen ); // restore dir_prefix
+  dircache_dir_t* cached = dircache_scan(cenv->env, sbuf_string(dir));
+  if (cached == NULL) return cont;
+  for (ssize_t i = 0; cont && i < cached->count; i++) {
+    dircache_entry_t* e = &cached->entries[i];
+    const char* name = e->name;
+    if (ic_istarts_with(name, base_prefix))
+    {
+      // possible match; determine the file type once and remember it
+      if (!e->known) {
+        const ssize_t dlen = sbuf_len(dir);
+        sbuf_append_char(dir,ic_dirsep());
+        sbuf_append(dir,name);
+        e->ft    = os_get_filetype(sbuf_string(dir));
+        e->isdir = os_is_dir(sbuf_string(dir));
+        e->known = true;
+        sbuf_delete_from(dir,dlen);  // restore dir
       }
-    } while (cont && os_findnext(d, &entry));
-    os_findclose(d);
+      const ssize_t plen = sbuf_len(dir_prefix);
+      sbuf_append(dir_prefix, name);
+      if (e->isdir && dir_sep != 0) {
+        sbuf_append_char(dir_prefix,dir_sep);
+      }
+      if (e->isdir || match_extension(name, extensions)) {
+        // add completion
+        sbuf_clear(display);
+        ls_colorize(cenv->env->no_lscolors, display, e->ft, name, NULL, (e->isdir ? dir_sep : 0));
+        cont = ic_add_completion_ex(cenv, sbuf_string(dir_prefix), sbuf_string(display), NULL);
+      }
+      sbuf_delete_from( dir_prefix, plen ); // restore dir_prefix
+    }
   }
   return cont;
 }
@@ -25,6 +25,8 @@ typedef struct completion_s {
   const char* help;
   ssize_t     delete_before;
   ssize_t     delete_after;
+  ssize_t     score;          // fuzzy match score (0 when fuzzy matching is off)
+  bool        prefix_match;   // does the replacement extend the typed text as-is? (always with exact matching)
 } completion_t;
 
 struct completions_s {
@@ -34,6 +36,16 @@ struct completions_s {
   ssize_t count;
   ssize_t len;
   completion_t* elems;
+  // hash set over the replacements so adding a completion does not
+  // strcmp every earlier one (slots hold indices into `elems`, -1 is empty)
+  ssize_t* dedup;
+  ssize_t  dedup_capacity;
+  bool     cancel_on_input;  // stop generating when a new keystroke arrives (hint generation)
+  bool     fuzzy;            // fuzzy (subsequence) matching and scoring (opt-in)
+  // the typed input being completed; only valid during `completions_generate`
+  // so a pushed completion can be scored against what it replaces
+  const char* match_input;
+  ssize_t     match_pos;
   alloc_t* mem;
 };
 
@@ -49,29 +61,120 @@ ic_private completions_t* completions_new(alloc_t* mem) {
 
 ic_private void completions_free(completions_t* cms) {
   if (cms == NULL) return;
-  completions_clear(cms);  
+  completions_clear(cms);
   if (cms->elems != NULL) {
     mem_free(cms->mem, cms->elems);
     cms->elems = NULL;
     cms->count = 0;
     cms->len = 0;
   }
+  mem_free(cms->mem, cms->dedup);
+  cms->dedup = NULL;
+  cms->dedup_capacity = 0;
   mem_free(cms->mem, cms); // free ourselves
 }
 
 
-ic_private void completions_clear(completions_t* cms) {  
+ic_private void completions_clear(completions_t* cms) {
   while (cms->count > 0) {
     completion_t* cm = cms->elems + cms->count - 1;
     mem_free( cms->mem, cm->display);
     mem_free( cms->mem, cm->replacement);
     mem_free( cms->mem, cm->help);
     memset(cm,0,sizeof(*cm));
-    cms->count--;    
+    cms->count--;
+  }
+  for (ssize_t i = 0; i < cms->dedup_capacity; i++) { cms->dedup[i] = -1; }
+}
+
+//-------------------------------------------------------------
+// Duplicate detection
+// A hash set over the replacement strings so completers that
+// emit many candidates do not strcmp every earlier completion
+// on each add. Slots hold indices into `elems` (-1 is empty).
+//-------------------------------------------------------------
+
+static uint32_t completions_hash( const char* s ) {
+  // FNV-1a
+  uint32_t h = 2166136261U;
+  while (*s != 0) {
+    h = (h ^ (uint8_t)(*s)) * 16777619U;
+    s++;
+  }
+  return h;
+}
+
+static ssize_t* completions_dedup_find_slot(completions_t* cms, const char* replacement) {
+  assert(cms->dedup != NULL && cms->dedup_capacity > 0);
+  ssize_t i = (ssize_t)(completions_hash(replacement) & (uint32_t)(cms->dedup_capacity - 1));
+  while (true) {
+    ssize_t* slot = &cms->dedup[i];
+    if (*slot < 0 || strcmp(cms->elems[*slot].replacement, replacement) == 0) return slot;
+    i = (i + 1) & (cms->dedup_capacity - 1);
   }
 }
 
-static void completions_push(completions_t* cms, const char* replacement, const char* display, const char* help, ssize_t delete_before, ssize_t delete_after) 
+static bool completions_dedup_ensure_extra(completions_t* cms, ssize_t extra) {
+  if (cms->dedup != NULL && 4*(cms->count + extra) <= 3*cms->dedup_capacity) return true;  // keep load under 75%
+  ssize_t newcap = (cms->dedup_capacity <= 0 ? 64 : 2*cms->dedup_capacity);
+  ssize_t* newslots = mem_malloc_tp_n(cms->mem, ssize_t, newcap);
+  if (newslots == NULL) return false;
+  for (ssize_t i = 0; i < newcap; i++) { newslots[i] = -1; }
+  mem_free(cms->mem, cms->dedup);
+  cms->dedup = newslots;
+  cms->dedup_capacity = newcap;
+  for (ssize_t i = 0; i < cms->count; i++) {
+    *completions_dedup_find_slot(cms, cms->elems[i].replacement) = i;
+  }
+  return true;
+}
+
+//-------------------------------------------------------------
+// Fuzzy matching (opt-in, see `ic_enable_fuzzy_completion`)
+// A candidate matches when the typed characters occur in order
+// (a subsequence); the score prefers consecutive matches and
+// matches at the start of the candidate or of a word in it, and
+// subtracts a little for each skipped character so the ordering
+// surfaces e.g. "git checkout" for "gco".
+//-------------------------------------------------------------
+
+static bool fuzzy_is_boundary(char prev) {
+  return (prev == ' ' || prev == '\t' || prev == '/' || prev == '\\' ||
+          prev == '_' || prev == '-' || prev == '.' || prev == ':');
+}
+
+// Score `candidate` against the typed `query` (case insensitive);
+// returns a negative score when the query is not a subsequence.
+static ssize_t fuzzy_score(const char* candidate, const char* query) {
+  if (candidate == NULL || query == NULL) return -1;
+  ssize_t score = 0;
+  ssize_t i = 0;
+  bool prev_matched = false;
+  for (ssize_t q = 0; query[q] != 0; q++) {
+    const char qc = ic_tolower(query[q]);
+    ssize_t gap = 0;
+    while (candidate[i] != 0 && ic_tolower(candidate[i]) != qc) {
+      i++; gap++;
+    }
+    if (candidate[i] == 0) return -1;  // not a subsequence
+    if (i == 0)                              { score += 16; }  // start of the candidate
+    else if (fuzzy_is_boundary(candidate[i-1])) { score += 12; }  // start of a word
+    else if (gap == 0 && prev_matched)       { score += 8; }   // consecutive match
+    else                                     { score += 2; }
+    score -= (gap > 8 ? 8 : gap);
+    prev_matched = true;
+    i++;
+  }
+  return score;
+}
+
+ic_private bool completions_enable_fuzzy(completions_t* cms, bool enable) {
+  bool prev = cms->fuzzy;
+  cms->fuzzy = enable;
+  return prev;
+}
+
+static void completions_push(completions_t* cms, const char* replacement, const char* display, const char* help, ssize_t delete_before, ssize_t delete_after)
 {
   if (cms->count >= cms->len) {
     ssize_t newlen = (cms->len <= 0 ? 32 : cms->len*2);
@@ -87,7 +190,19 @@ static void completions_push(completions_t* cms, const char* replacement, const
   cm->help          = mem_strdup(cms->mem,help);
   cm->delete_before = delete_before;
   cm->delete_after  = delete_after;
+  cm->score         = 0;
+  cm->prefix_match  = true;
+  if (cms->fuzzy && cms->match_input != NULL &&
+      delete_before > 0 && delete_before <= cms->match_pos && cm->replacement != NULL) {
+    // score against the typed text this completion replaces
+    const char* query = cms->match_input + (cms->match_pos - delete_before);
+    cm->score = fuzzy_score(cm->replacement, query);
+    cm->prefix_match = ic_istarts_with(cm->replacement, query);
+  }
   cms->count++;
+  if (cm->replacement != NULL && completions_dedup_ensure_extra(cms,0)) {
+    *completions_dedup_find_slot(cms, cm->replacement) = cms->count - 1;
+  }
 }
 
 ic_private ssize_t completions_count(completions_t* cms) {
@@ -95,12 +210,16 @@ ic_private ssize_t completions_count(completions_t* cms) {
 }
 
 static bool completions_contains(completions_t* cms, const char* replacement) {
+  if (completions_dedup_ensure_extra(cms,1)) {
+    return (*completions_dedup_find_slot(cms, replacement) >= 0);
+  }
+  // no memory for the hash set; fall back to a scan
   for( ssize_t i = 0; i < cms->count; i++ ) {
     const completion_t* c = cms->elems + i;
     if (strcmp(replacement,c->replacement) == 0) { return true; }
   }
   return false;
-} 
+}
 
 ic_private bool completions_add(completions_t* cms, const char* replacement, const char* display, const char* help, ssize_t delete_before, ssize_t delete_after) {
   if (cms->completer_max <= 0) return false;
@@ -135,6 +254,7 @@ ic_private const char* completions_get_hint(completions_t* cms, ssize_t index, c
   if (help != NULL) { *help = NULL; }
   completion_t* cm = completions_get(cms, index);
   if (cm == NULL) return NULL;
+  if (!cm->prefix_match) return NULL;  // a fuzzy match cannot show as an inline continuation
   ssize_t len = ic_strlen(cm->replacement);
   if (len < cm->delete_before) return NULL;
   const char* hint = (cm->replacement + cm->delete_before);
@@ -143,6 +263,12 @@ ic_private const char* completions_get_hint(completions_t* cms, ssize_t index, c
   return hint;
 }
 
+ic_private bool completions_enable_cancel_on_input(completions_t* cms, bool enable) {
+  bool prev = cms->cancel_on_input;
+  cms->cancel_on_input = enable;
+  return prev;
+}
+
 ic_private void completions_set_completer(completions_t* cms, ic_completer_fun_t* completer, void* arg) {
   cms->completer = completer;
   cms->completer_arg = arg;
@@ -163,7 +289,9 @@ ic_public bool ic_has_completions( const ic_completion_env_t* cenv ) {
 }
 
 ic_public bool ic_stop_completing( const ic_completion_env_t* cenv) {
-  return (cenv == NULL ? true : cenv->env->completions->completer_max <= 0);
+  if (cenv == NULL) return true;
+  if (cenv->env->completions->completer_max <= 0) return true;
+  return (cenv->env->completions->cancel_on_input && tty_has_input(cenv->env->tty));
 }
 
 
@@ -192,7 +320,10 @@ ic_private ssize_t completions_apply( completions_t* cms, ssize_t index, stringb
 static int completion_compare(const void* p1, const void* p2) {
   if (p1 == NULL || p2 == NULL) return 0;
   const completion_t* cm1 = (const completion_t*)p1;
-  const completion_t* cm2 = (const completion_t*)p2;  
+  const completion_t* cm2 = (const completion_t*)p2;
+  if (cm1->score != cm2->score) {
+    return (cm1->score > cm2->score ? -1 : 1);  // best fuzzy score first
+  }
   return ic_stricmp(cm1->replacement, cm2->replacement);
 }
 
@@ -201,6 +332,27 @@ ic_private void completions_sort(completions_t* cms) {
   qsort(cms->elems, to_size_t(cms->count), sizeof(cms->elems[0]), &completion_compare);
 }
 
+// Order only the first `k` completions (one menu page); with a large
+// candidate set this selects the top entries in O(k*n) instead of
+// sorting everything that is never displayed. (Sorting permutes `elems`
+// and leaves the dedup set stale but that is only used during
+// generation, before any sort.)
+ic_private void completions_sort_top(completions_t* cms, ssize_t k) {
+  if (cms->count <= 0) return;
+  if (k >= cms->count) { completions_sort(cms); return; }
+  for (ssize_t i = 0; i < k; i++) {
+    ssize_t min = i;
+    for (ssize_t j = i+1; j < cms->count; j++) {
+      if (completion_compare(&cms->elems[j], &cms->elems[min]) < 0) { min = j; }
+    }
+    if (min != i) {
+      completion_t tmp = cms->elems[i];
+      cms->elems[i] = cms->elems[min];
+      cms->elems[min] = tmp;
+    }
+  }
+}
+
 #define IC_MAX_PREFIX  (256)
 
 // find longest common prefix and complete with that.
@@ -262,8 +414,9 @@ ic_private ssize_t completions_apply_longest_prefix(completions_t* cms, stringbu
 //-------------------------------------------------------------
 
 ic_public bool ic_add_completions(ic_completion_env_t* cenv, const char* prefix, const char** completions) {
+  const bool fuzzy = cenv->env->completions->fuzzy;
   for (const char** pc = completions; *pc != NULL; pc++) {
-    if (ic_istarts_with(*pc, prefix)) {
+    if (fuzzy ? (fuzzy_score(*pc, prefix) >= 0) : ic_istarts_with(*pc, prefix)) {
       if (!ic_add_completion_ex(cenv, *pc, NULL, NULL)) return false;
     }
   }
@@ -284,6 +437,9 @@ ic_public bool ic_add_completion_prim(ic_completion_env_t* cenv, const char* rep
 
 static bool prim_add_completion(ic_env_t* env, void* funenv, const char* replacement, const char* display, const char* help, long delete_before, long delete_after) {
   ic_unused(funenv);
+  if (env->completions->cancel_on_input && tty_has_input(env->tty)) {
+    return false;  // a new keystroke cancels this generation
+  }
   return completions_add(env->completions, replacement, display, help, delete_before, delete_after);
 }
 
@@ -306,11 +462,15 @@ ic_private ssize_t completions_generate(struct ic_env_s* env, completions_t* cms
   cenv.closure  = NULL;
   const char* prefix = mem_strndup(cms->mem, input, pos);
   cms->completer_max = max;
-  
+  cms->match_input = prefix;   // for fuzzy scoring of pushed completions
+  cms->match_pos   = pos;
+
   // and complete
   cms->completer(&cenv,prefix);
 
   // restore
+  cms->match_input = NULL;
+  cms->match_pos = 0;
   mem_free(cms->mem,prefix);
   return completions_count(cms);
 }
@@ -324,3 +484,124 @@ static void default_filename_completer( ic_completion_env_t* cenv, const char* p
   #endif
   ic_complete_filename( cenv, prefix, sep, ".", NULL);
 }
+
+//-------------------------------------------------------------
+// Prebuilt word completer: the word table is sorted (and the
+// strings interned) once so every query -- each tab press and
+// each hint -- finds the matching range by binary search
+// instead of scanning the whole list.
+//-------------------------------------------------------------
+
+typedef struct completer_word_s {
+  const char* word;     // interned replacement; the sort key
+  const char* display;  // can be NULL
+  const char* help;     // can be NULL
+} completer_word_t;
+
+struct ic_completer_s {
+  completer_word_t* words;  // sorted on `word` (case insensitive)
+  ssize_t  count;
+  alloc_t* mem;
+};
+
+// lexicographic and case insensitive so the order agrees with the
+// `ic_strnicmp` prefix probes of the binary search
+// (note: `ic_stricmp` compares lengths first and cannot be used here)
+static int completer_word_compare( const void* p1, const void* p2 ) {
+  const char* s1 = ((const completer_word_t*)p1)->word;
+  const char* s2 = ((const completer_word_t*)p2)->word;
+  ssize_t i;
+  for (i = 0; s1[i] != 0 && s2[i] != 0; i++) {
+    const char c1 = ic_tolower(s1[i]);
+    const char c2 = ic_tolower(s2[i]);
+    if (c1 != c2) { return (c1 < c2 ? -1 : 1); }
+  }
+  if (s1[i] != s2[i]) { return (s1[i] == 0 ? -1 : 1); }
+  return strcmp(s1, s2);  // fixed order for case variants
+}
+
+ic_public ic_completer_t* ic_completer_from_words( const ic_completion_entry_t* entries, size_t count ) {
+  ic_env_t* env = ic_get_env(); if (env == NULL || entries == NULL) return NULL;
+  ic_completer_t* c = mem_zalloc_tp(env->mem, ic_completer_t);
+  if (c == NULL) return NULL;
+  c->mem = env->mem;
+  if (count > 0) {
+    c->words = mem_zalloc_tp_n(c->mem, completer_word_t, to_ssize_t(count));
+    if (c->words == NULL) { mem_free(c->mem, c); return NULL; }
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (entries[i].replacement == NULL) continue;
+    completer_word_t* w = &c->words[c->count];
+    w->word = mem_strdup(c->mem, entries[i].replacement);
+    if (w->word == NULL) break;
+    w->display = mem_strdup(c->mem, entries[i].display);
+    w->help    = mem_strdup(c->mem, entries[i].help);
+    c->count++;
+  }
+  if (c->count > 1) {
+    qsort(c->words, to_size_t(c->count), sizeof(completer_word_t), &completer_word_compare);
+  }
+  return c;
+}
+
+ic_public void ic_completer_free( ic_completer_t* c ) {
+  if (c == NULL) return;
+  for (ssize_t i = 0; i < c->count; i++) {
+    mem_free(c->mem, c->words[i].word);
+    mem_free(c->mem, c->words[i].display);
+    mem_free(c->mem, c->words[i].help);
+  }
+  mem_free(c->mem, c->words);
+  mem_free(c->mem, c);
+}
+
+// first index whose word does not sort before the prefix
+static ssize_t completer_lower_bound( const ic_completer_t* c, const char* prefix, ssize_t plen ) {
+  ssize_t lo = 0;
+  ssize_t hi = c->count;
+  while (lo < hi) {
+    const ssize_t mid = lo + (hi - lo)/2;
+    if (ic_strnicmp(c->words[mid].word, prefix, plen) < 0) { lo = mid+1; }
+                                                      else { hi = mid; }
+  }
+  return lo;
+}
+
+ic_public bool ic_add_completions_from( ic_completion_env_t* cenv, const char* prefix, const ic_completer_t* completer ) {
+  if (completer == NULL || prefix == NULL) return true;
+  if (cenv->env->completions->fuzzy) {
+    // a fuzzy query matches subsequences anywhere; scan like ic_add_completions
+    for (ssize_t i = 0; i < completer->count; i++) {
+      const completer_word_t* w = &completer->words[i];
+      if (fuzzy_score(w->word, prefix) >= 0) {
+        if (!ic_add_completion_ex(cenv, w->word, w->display, w->help)) return false;
+      }
+    }
+    return true;
+  }
+  // binary search for the start of the matching range
+  const ssize_t plen = ic_strlen(prefix);
+  for (ssize_t i = completer_lower_bound(completer, prefix, plen); i < completer->count; i++) {
+    const completer_word_t* w = &completer->words[i];
+    if (ic_strnicmp(w->word, prefix, plen) != 0) break;  // past the range
+    if (!ic_add_completion_ex(cenv, w->word, w->display, w->help)) return false;
+  }
+  return true;
+}
+
+// adapter so the prebuilt completer plugs in as an `ic_completer_fun_t`
+static void completer_word_fun( ic_completion_env_t* cenv, const char* prefix ) {
+  ic_add_completions_from(cenv, prefix, (const ic_completer_t*)cenv->arg);
+}
+
+ic_public void ic_complete_word_from( ic_completion_env_t* cenv, const char* prefix, const ic_completer_t* completer,
+                                          ic_is_char_class_fun_t* is_word_char ) {
+  void* prev_arg = cenv->arg;
+  cenv->arg = (void*)completer;
+  ic_complete_word(cenv, prefix, &completer_word_fun, is_word_char);
+  cenv->arg = prev_arg;
+}
+
+ic_public void ic_completer_word_fun( ic_completion_env_t* cenv, const char* prefix ) {
+  ic_complete_word_from(cenv, prefix, (const ic_completer_t*)cenv->arg, NULL);
+}
@@ -27,6 +27,9 @@ ic_private bool        completions_add(completions_t* cms , const char* replacem
 ic_private ssize_t     completions_count(completions_t* cms);
 ic_private ssize_t     completions_generate(struct ic_env_s* env, completions_t* cms , const char* input, ssize_t pos, ssize_t max);
 ic_private void        completions_sort(completions_t* cms);
+ic_private void        completions_sort_top(completions_t* cms, ssize_t k);
+ic_private bool        completions_enable_cancel_on_input(completions_t* cms, bool enable);
+ic_private bool        completions_enable_fuzzy(completions_t* cms, bool enable);
 ic_private void        completions_set_completer(completions_t* cms, ic_completer_fun_t* completer, void* arg);
 ic_private const char* completions_get_display(completions_t* cms , ssize_t index, const char** help);
 ic_private const char* completions_get_hint(completions_t* cms, ssize_t index, const char** help);
@@ -17,6 +17,126 @@
 #include "undo.h"
 #include "highlight.h"
 
+//-------------------------------------------------------------
+// The render cache
+// Remember the text and attributes of each row as it was last
+// rendered so a refresh only re-emits rows (or row tails) that
+// actually changed. This keeps the output per keystroke small
+// which matters for large multi-line inputs on slow (ssh)
+// connections.
+//-------------------------------------------------------------
+
+// one row as it was last rendered on screen
+typedef struct rrow_s {
+  stringbuf_t*  text;           // the rendered row text (without the prompt)
+  attr_t*       attrs;          // per-byte attributes, or NULL if rendered plain
+  ssize_t       attrs_capacity; // allocated attribute entries
+  bool          has_attrs;      // was the row rendered with attributes?
+  bool          is_wrap;        // was the row rendered with a wrap marker?
+} rrow_t;
+
+typedef struct rcache_s {
+  alloc_t*  mem;
+  rrow_t*   rows;               // cached screen rows (relative to the first visible row)
+  ssize_t   count;              // number of valid rows
+  ssize_t   capacity;
+  ssize_t   termw;              // terminal width at the time of rendering
+  ssize_t   first_row;          // first visible row at the time of rendering
+} rcache_t;
+
+static void rcache_init( rcache_t* rc, alloc_t* mem ) {
+  memset(rc, 0, sizeof(*rc));
+  rc->mem = mem;
+  rc->termw = -1;
+}
+
+static void rcache_invalidate( rcache_t* rc ) {
+  rc->count = 0;
+}
+
+static void rcache_done( rcache_t* rc ) {
+  for (ssize_t i = 0; i < rc->capacity; i++) {
+    sbuf_free(rc->rows[i].text);
+    mem_free(rc->mem, rc->rows[i].attrs);
+  }
+  mem_free(rc->mem, rc->rows);
+  rc->rows = NULL;
+  rc->count = 0;
+  rc->capacity = 0;
+}
+
+// invalidate the cache if the screen layout shifted (resize or scroll)
+static void rcache_start_refresh( rcache_t* rc, ssize_t termw, ssize_t first_row ) {
+  if (rc->termw != termw || rc->first_row != first_row) {
+    rcache_invalidate(rc);
+    rc->termw = termw;
+    rc->first_row = first_row;
+  }
+}
+
+// drop cached rows that are no longer on screen
+static void rcache_trim( rcache_t* rc, ssize_t count ) {
+  if (rc->count > count) rc->count = count;
+}
+
+// get a cached row, or NULL if it was not rendered before
+static rrow_t* rcache_row( rcache_t* rc, ssize_t idx ) {
+  if (idx < 0 || idx >= rc->count) return NULL;
+  rrow_t* rr = &rc->rows[idx];
+  return (rr->text == NULL ? NULL : rr);
+}
+
+// the common prefix (in bytes, on a codepoint boundary) that is still valid on screen
+static ssize_t rrow_common_prefix( rrow_t* rr, const char* s, const attr_t* attrs, ssize_t len ) {
+  if (rr->has_attrs != (attrs != NULL)) return 0;
+  const char* t = sbuf_string(rr->text);
+  ssize_t n = sbuf_len(rr->text);
+  if (len < n) n = len;
+  ssize_t i = 0;
+  while (i < n && t[i] == s[i] && (attrs == NULL || attr_is_eq(rr->attrs[i], attrs[i]))) {
+    i++;
+  }
+  // stay on a codepoint boundary
+  while (i > 0 && utf8_is_cont((uint8_t)s[i])) {
+    i--;
+  }
+  return i;
+}
+
+// remember a row as it is being rendered
+static void rcache_update( rcache_t* rc, ssize_t idx, const char* s, const attr_t* attrs, ssize_t len, bool is_wrap ) {
+  if (idx < 0) return;
+  if (idx >= rc->capacity) {
+    ssize_t newcap = (rc->capacity <= 0 ? 16 : 2*rc->capacity);
+    if (newcap <= idx) newcap = idx + 1;
+    rrow_t* newrows = mem_realloc_tp(rc->mem, rrow_t, rc->rows, newcap);
+    if (newrows == NULL) return;
+    memset(newrows + rc->capacity, 0, to_size_t(newcap - rc->capacity) * sizeof(rrow_t));
+    rc->rows = newrows;
+    rc->capacity = newcap;
+  }
+  rrow_t* rr = &rc->rows[idx];
+  if (rr->text == NULL) {
+    rr->text = sbuf_new(rc->mem);
+    if (rr->text == NULL) return;
+  }
+  sbuf_clear(rr->text);
+  sbuf_append_n(rr->text, s, len);
+  rr->has_attrs = (attrs != NULL);
+  if (attrs != NULL && len > 0) {
+    if (rr->attrs_capacity < len) {
+      attr_t* newattrs = mem_realloc_tp(rc->mem, attr_t, rr->attrs, (len > 0 ? len : 1));
+      if (newattrs == NULL) { rr->has_attrs = false; return; }
+      rr->attrs = newattrs;
+      rr->attrs_capacity = len;
+    }
+    ic_memcpy(rr->attrs, attrs, len * ssizeof(attr_t));
+  }
+  rr->is_wrap = is_wrap;
+  if (rc->count <= idx) rc->count = idx + 1;
+}
+
+
 //-------------------------------------------------------------
 // The editor state
 //-------------------------------------------------------------
@@ -33,16 +153,20 @@ typedef struct editor_s {
   ssize_t       cur_rows;     // current used rows to display our content (including extra content)
   ssize_t       cur_row;      // current row that has the cursor (0 based, relative to the prompt)
   ssize_t       termw;
-  bool          modified;     // has a modification happened? (used for history navigation for example)  
+  bool          modified;     // has a modification happened? (used for history navigation for example)
   bool          disable_undo; // temporarily disable auto undo (for history search)
+  bool          hint_pending; // is a (debounced) hint generation scheduled?
   ssize_t       history_idx;  // current index in the history 
   editstate_t*  undo;         // undo buffer  
   editstate_t*  redo;         // redo buffer
-  const char*   prompt_text;  // text of the prompt before the prompt marker    
+  const char*   prompt_text;  // text of the prompt before the prompt marker
+  code_t        last_code;    // the key code that terminated the edit session
   alloc_t*      mem;          // allocator
   // caches
-  attrbuf_t*    attrs;        // reuse attribute buffers 
-  attrbuf_t*    attrs_extra; 
+  attrbuf_t*    attrs;        // reuse attribute buffers
+  attrbuf_t*    attrs_extra;
+  attrbuf_t*    attrs_hl;     // cached highlighter output (for incremental highlighting)
+  rcache_t      rcache;       // last rendered rows for incremental redraw
 } editor_t;
 
 
@@ -56,6 +180,7 @@ static char* edit_line( ic_env_t* env, const char* prompt_text );  // defined at
 static void edit_refresh(ic_env_t* env, editor_t* eb);
 
 ic_private char* ic_editline(ic_env_t* env, const char* prompt_text) {
+  if (env->async_edit != NULL) return NULL;  // no blocking read during an async session
   tty_start_raw(env->tty);
   term_start_raw(env->term);
   char* line = edit_line(env,prompt_text);
@@ -72,47 +197,47 @@ ic_private char* ic_editline(ic_env_t* env, const char* prompt_text) {
 //-------------------------------------------------------------
 
 // capture the current edit state
-static void editor_capture(editor_t* eb, editstate_t** es ) {
+static void editor_capture(editor_t* eb, editstate_t* es ) {
   if (!eb->disable_undo) {
-    editstate_capture( eb->mem, es, sbuf_string(eb->input), eb->pos );
+    editstate_capture( es, sbuf_string(eb->input), eb->pos );
   }
 }
 
 static void editor_undo_capture(editor_t* eb ) {
-  editor_capture(eb, &eb->undo );
+  editor_capture(eb, eb->undo );
 }
 
 static void editor_undo_forget(editor_t* eb) {
   if (eb->disable_undo) return;
   const char* input = NULL;
   ssize_t pos = 0;
-  editstate_restore(eb->mem, &eb->undo, &input, &pos);
+  editstate_restore(eb->undo, &input, &pos);
   mem_free(eb->mem, input);
 }
 
-static void editor_restore(editor_t* eb, editstate_t** from, editstate_t** to ) {
+static void editor_restore(editor_t* eb, editstate_t* from, editstate_t* to ) {
   if (eb->disable_undo) return;
-  if (*from == NULL) return;
+  if (editstate_is_empty(from)) return;
   const char* input;
   if (to != NULL) { editor_capture( eb, to ); }
-  if (!editstate_restore( eb->mem, from, &input, &eb->pos )) return;
+  if (!editstate_restore( from, &input, &eb->pos )) return;
   sbuf_replace( eb->input, input );
   mem_free(eb->mem, input);
   eb->modified = false;
 }
 
 static void editor_undo_restore(editor_t* eb, bool with_redo ) {
-  editor_restore(eb, &eb->undo, (with_redo ? &eb->redo : NULL));
+  editor_restore(eb, eb->undo, (with_redo ? eb->redo : NULL));
 }
 
 static void editor_redo_restore(editor_t* eb ) {
-  editor_restore(eb, &eb->redo, &eb->undo);
+  editor_restore(eb, eb->redo, eb->undo);
   eb->modified = false;
 }
 
 static void editor_start_modify(editor_t* eb ) {
   editor_undo_capture(eb);
-  editstate_done(eb->mem, &eb->redo);  // clear redo
+  editstate_clear(eb->redo);  // clear redo
   eb->modified = true;
 }
 
@@ -196,37 +321,64 @@ typedef struct refresh_info_s {
   bool        in_extra;
   ssize_t     first_row;
   ssize_t     last_row;
+  ssize_t     row_offset;   // rows that precede this buffer on screen (used for the extra rows)
+  ssize_t     screen_first; // first visible row over all buffers
 } refresh_info_t;
 
 static bool edit_refresh_rows_iter(
     const char* s,
-    ssize_t row, ssize_t row_start, ssize_t row_len, 
+    ssize_t row, ssize_t row_start, ssize_t row_len,
     ssize_t startw, bool is_wrap, const void* arg, void* res)
 {
-  ic_unused(res); ic_unused(startw);
+  ic_unused(res);
   const refresh_info_t* info = (const refresh_info_t*)(arg);
   term_t* term = info->env->term;
 
   // debug_msg("edit: line refresh: row %zd, len: %zd\n", row, row_len);
   if (row < info->first_row) return false;
   if (row > info->last_row)  return true; // should not occur
-  
-  // term_clear_line(term);
-  edit_write_prompt(info->env, info->eb, row, info->in_extra);
+  const bool last = (row >= info->last_row);
+
+  const bool use_attrs = (info->attrs != NULL && !(info->env->no_highlight && info->env->no_bracematch));
+  const attr_t* row_attrs = (use_attrs ? attrbuf_attrs(info->attrs, row_start + row_len) + row_start : NULL);
+
+  // use the render cache to only re-emit the part of the row that changed on screen
+  rcache_t* rcache = &info->eb->rcache;
+  const ssize_t cache_idx = row + info->row_offset - info->screen_first;
+  rrow_t* cached = rcache_row(rcache, cache_idx);
+  ssize_t prefix = 0;
+  if (cached != NULL) {
+    prefix = rrow_common_prefix(cached, s + row_start, row_attrs, row_len);
+    if (prefix == row_len && sbuf_len(cached->text) == row_len && cached->is_wrap == is_wrap) {
+      // row is unchanged on screen: just move to the next row
+      if (!last) { term_writeln(term, ""); }
+      return last;
+    }
+  }
+  if (cached != NULL && prefix > 0) {
+    // prefix is unchanged: skip over it and only rewrite the tail
+    term_start_of_line(term);
+    term_right(term, startw + str_column_width_n(s + row_start, prefix));
+  }
+  else {
+    // full rewrite including the prompt
+    prefix = 0;
+    edit_write_prompt(info->env, info->eb, row, info->in_extra);
+  }
 
   //' write output
-  if (info->attrs == NULL || (info->env->no_highlight && info->env->no_bracematch)) {
-    term_write_n( term, s + row_start, row_len );
+  if (row_attrs == NULL) {
+    term_write_n( term, s + row_start + prefix, row_len - prefix );
   }
   else {
-    term_write_formatted_n( term, s + row_start, attrbuf_attrs(info->attrs, row_start + row_len) + row_start, row_len );
+    term_write_formatted_n( term, s + row_start + prefix, row_attrs + prefix, row_len - prefix );
   }
 
   // write line ending
-  if (row < info->last_row) {
-    if (is_wrap && tty_is_utf8(info->env->tty)) {       
+  if (!last) {
+    if (is_wrap && tty_is_utf8(info->env->tty)) {
       #ifndef __APPLE__
-      bbcode_print( info->env->bbcode, "[ic-dim]\xE2\x86\x90");  // left arrow 
+      bbcode_print( info->env->bbcode, "[ic-dim]\xE2\x86\x90");  // left arrow
       #else
       bbcode_print( info->env->bbcode, "[ic-dim]\xE2\x86\xB5" ); // return symbol
       #endif
@@ -237,12 +389,14 @@ static bool edit_refresh_rows_iter(
   else {
     term_clear_to_end_of_line(term);
   }
-  return (row >= info->last_row);  
+  rcache_update(rcache, cache_idx, s + row_start, row_attrs, row_len, is_wrap);
+  return last;
 }
 
 static void edit_refresh_rows(ic_env_t* env, editor_t* eb, stringbuf_t* input, attrbuf_t* attrs,
-                               ssize_t promptw, ssize_t cpromptw, bool in_extra, 
-                                ssize_t first_row, ssize_t last_row) 
+                               ssize_t promptw, ssize_t cpromptw, bool in_extra,
+                                ssize_t first_row, ssize_t last_row,
+                                 ssize_t row_offset, ssize_t screen_first)
 {
   if (input == NULL) return;
   refresh_info_t info;
@@ -252,19 +406,28 @@ static void edit_refresh_rows(ic_env_t* env, editor_t* eb, stringbuf_t* input, a
   info.in_extra   = in_extra;
   info.first_row  = first_row;
   info.last_row   = last_row;
+  info.row_offset = row_offset;
+  info.screen_first = screen_first;
   sbuf_for_each_row( input, eb->termw, promptw, cpromptw, &edit_refresh_rows_iter, &info, NULL);
 }
 
 
-static void edit_refresh(ic_env_t* env, editor_t* eb) 
+static void edit_refresh(ic_env_t* env, editor_t* eb)
 {
+  ic_stats_timed_begin();
   // calculate the new cursor row and total rows needed
   ssize_t promptw, cpromptw;
   edit_get_prompt_width( env, eb, false, &promptw, &cpromptw );
   
   if (eb->attrs != NULL) {
-    highlight( env->mem, env->bbcode, sbuf_string(eb->input), eb->attrs, 
-                 (env->no_highlight ? NULL : env->highlighter), env->highlighter_arg );
+    if (env->incremental_highlight && !env->no_highlight && env->highlighter != NULL && eb->attrs_hl != NULL) {
+      highlight_incremental( env->mem, env->bbcode, eb->input, eb->attrs, eb->attrs_hl,
+                               env->highlighter, env->highlighter_arg );
+    }
+    else {
+      highlight( env->mem, env->bbcode, sbuf_string(eb->input), eb->attrs,
+                   (env->no_highlight ? NULL : env->highlighter), env->highlighter_arg );
+    }
   }
 
   // highlight matching braces
@@ -314,25 +477,29 @@ static void edit_refresh(ic_env_t* env, editor_t* eb)
     last_row = first_row + termh - 1;
   }
   assert(last_row - first_row < termh);
-  
+
+  // invalidate the render cache if the screen layout shifted
+  rcache_start_refresh(&eb->rcache, eb->termw, first_row);
+
   // reduce flicker
-  buffer_mode_t bmode = term_set_buffer_mode(env->term, BUFFERED);        
+  buffer_mode_t bmode = term_set_buffer_mode(env->term, BUFFERED);
 
   // back up to the first line
   term_start_of_line(env->term);
   term_up(env->term, (eb->cur_row >= termh ? termh-1 : eb->cur_row) );
-  // term_clear_lines_to_end(env->term);  // gives flicker in old Windows cmd prompt 
+  // term_clear_lines_to_end(env->term);  // gives flicker in old Windows cmd prompt
 
   // render rows
-  edit_refresh_rows( env, eb, eb->input, eb->attrs, promptw, cpromptw, false, first_row, last_row );  
+  edit_refresh_rows( env, eb, eb->input, eb->attrs, promptw, cpromptw, false, first_row, last_row, 0, first_row );
   if (rows_extra > 0) {
     assert(extra != NULL);
     const ssize_t first_rowx = (first_row > rows_input ? first_row - rows_input : 0);
     const ssize_t last_rowx = last_row - rows_input; assert(last_rowx >= 0);
-    edit_refresh_rows(env, eb, extra, eb->attrs_extra, 0, 0, true, first_rowx, last_rowx);
+    edit_refresh_rows(env, eb, extra, eb->attrs_extra, 0, 0, true, first_rowx, last_rowx, rows_input, first_row);
   }
-    
-  // overwrite trailing rows we do not use anymore  
+  rcache_trim(&eb->rcache, last_row - first_row + 1);
+
+  // overwrite trailing rows we do not use anymore
   ssize_t rrows = last_row - first_row + 1;  // rendered rows
   if (rrows < termh && rows < eb->cur_rows) {
     ssize_t clear = eb->cur_rows - rows;
@@ -365,11 +532,13 @@ static void edit_refresh(ic_env_t* env, editor_t* eb)
   // update previous
   eb->cur_rows = rows;
   eb->cur_row = rc.row;
+  ic_stats_timed_end(refresh_count, refresh_nsecs);
 }
 
 // clear current output
 static void edit_clear(ic_env_t* env, editor_t* eb ) {
-  term_attr_reset(env->term);  
+  rcache_invalidate(&eb->rcache);   // everything is overwritten
+  term_attr_reset(env->term);
   term_up(env->term, eb->cur_row);
   
   // overwrite all rows
@@ -395,8 +564,12 @@ static void edit_clear_screen(ic_env_t* env, editor_t* eb ) {
 
 // refresh after a terminal window resized (but before doing further edit operations!)
 static bool edit_resize(ic_env_t* env, editor_t* eb ) {
-  // update dimensions
+  // update dimensions; a live window drag delivers resize events in a burst
+  // but the event is just a flag so a burst coalesces into one rewrap of the
+  // settled width. Consume an event that raced with the measurement so it
+  // does not schedule a redundant rewrap on the next key.
   term_update_dim(env->term);
+  tty_term_resize_event(env->tty);
   ssize_t newtermw = term_get_width(env->term);
   if (eb->termw == newtermw) return false;
   
@@ -449,15 +622,10 @@ static void editor_append_hint_help(editor_t* eb, const char* help) {
   }
 }
 
-// refresh with possible hint
-static void edit_refresh_hint(ic_env_t* env, editor_t* eb) {
-  if (env->no_hint || env->hint_delay > 0) {
-    // refresh without hint first
-    edit_refresh(env, eb);
-    if (env->no_hint) return;
-  }
-    
-  // and see if we can construct a hint (displayed after a delay)
+// generate the inline hint by running the completer (see `edit_refresh_hint`);
+// canceled cooperatively when a new keystroke arrives during generation
+static void edit_hint_generate(ic_env_t* env, editor_t* eb) {
+  const bool prev_cancel = completions_enable_cancel_on_input(env->completions, true);
   ssize_t count = completions_generate(env, env->completions, sbuf_string(eb->input), eb->pos, 2);
   if (count == 1) {
     const char* help = NULL;
@@ -486,17 +654,29 @@ static void edit_refresh_hint(ic_env_t* env, editor_t* eb) {
               }
             }
           }
-          while(count == 1);       
+          while(count == 1);
           sbuf_free(sb);
-        }          
-      }      
+        }
+      }
     }
   }
+  completions_enable_cancel_on_input(env->completions, prev_cancel);
+}
 
-  if (env->hint_delay <= 0) {
-    // refresh with hint directly
+// refresh with possible hint
+static void edit_refresh_hint(ic_env_t* env, editor_t* eb) {
+  if (env->no_hint || env->hint_delay > 0) {
+    // refresh without hint first
     edit_refresh(env, eb);
+    if (env->no_hint) return;
+    // debounce: generate the hint off the keystroke path, once no new key
+    // arrives within the hint delay (see the read loop in `edit_line`)
+    eb->hint_pending = true;
+    return;
   }
+  edit_hint_generate(env, eb);
+  // refresh with hint directly
+  edit_refresh(env, eb);
 }
 
 //-------------------------------------------------------------
@@ -817,7 +997,34 @@ static void edit_insert_char(ic_env_t* env, editor_t* eb, char c) {
   if (c=='\n') {
     editor_auto_indent(eb, "{", "}");  // todo: custom auto indent tokens?
   }
-  edit_refresh_hint(env,eb);  
+  edit_refresh_hint(env,eb);
+}
+
+// Insert a bracketed paste as one edit operation: a single undo capture,
+// a bulk insert, and one refresh (instead of one of each per pasted character).
+static void edit_insert_paste(ic_env_t* env, editor_t* eb) {
+  stringbuf_t* paste = sbuf_new(eb->mem);
+  if (paste == NULL) return;
+  tty_read_bracketed_paste(env->tty, paste);
+  const char* s = sbuf_string(paste);
+  const ssize_t len = sbuf_len(paste);
+  if (len > 0) {
+    editor_start_modify(eb);
+    ssize_t i = 0;
+    while (i < len) {
+      ssize_t end = i;
+      while (end < len && s[end] != '\r') { end++; }
+      eb->pos = sbuf_insert_at_n(eb->input, s + i, end - i, eb->pos);
+      i = end;
+      if (i < len) {
+        // normalize a pasted '\r' or "\r\n" to a single '\n'
+        eb->pos = sbuf_insert_at_n(eb->input, "\n", 1, eb->pos);
+        i += (i + 1 < len && s[i + 1] == '\n' ? 2 : 1);
+      }
+    }
+  }
+  sbuf_free(paste);
+  edit_refresh(env, eb);
 }
 
 //-------------------------------------------------------------
@@ -843,300 +1050,412 @@ static void edit_insert_char(ic_env_t* env, editor_t* eb, char c) {
 // Edit line: main edit loop
 //-------------------------------------------------------------
 
+static bool  edit_init(ic_env_t* env, editor_t* eb, const char* prompt_text);
+static bool  edit_step(ic_env_t* env, editor_t* eb, code_t c);
+static char* edit_finish(ic_env_t* env, editor_t* eb);
+
 static char* edit_line( ic_env_t* env, const char* prompt_text )
 {
-  // set up an edit buffer
   editor_t eb;
-  memset(&eb, 0, sizeof(eb));
-  eb.mem      = env->mem;
-  eb.input    = sbuf_new(env->mem);
-  eb.extra    = sbuf_new(env->mem);
-  eb.hint     = sbuf_new(env->mem);
-  eb.hint_help= sbuf_new(env->mem);
-  eb.termw    = term_get_width(env->term);  
-  eb.pos      = 0;
-  eb.cur_rows = 1; 
-  eb.cur_row  = 0; 
-  eb.modified = false;  
-  eb.prompt_text   = (prompt_text != NULL ? prompt_text : "");
-  eb.history_idx   = 0;  
-  editstate_init(&eb.undo);
-  editstate_init(&eb.redo);
-  if (eb.input==NULL || eb.extra==NULL || eb.hint==NULL || eb.hint_help==NULL) {
-    return NULL;
-  }
-
-  // caching
-  if (!(env->no_highlight && env->no_bracematch)) {
-    eb.attrs = attrbuf_new(env->mem);
-    eb.attrs_extra = attrbuf_new(env->mem);
-  }
-  
-  // show prompt
-  edit_write_prompt(env, &eb, 0, false);   
-
-  // always a history entry for the current input
-  history_push(env->history, "");
+  if (!edit_init(env, &eb, prompt_text)) return NULL;
 
   // process keys
-  code_t c;          // current key code
-  while(true) {    
+  while(true) {
     // read a character
+    code_t c;
     term_flush(env->term);
-    if (env->hint_delay <= 0 || sbuf_len(eb.hint) == 0) {
+    if (env->hint_delay <= 0 || !eb.hint_pending) {
       // blocking read
       c = tty_read(env->tty);
     }
     else {
-      // timeout to display hint
+      // a hint generation is scheduled; run it only once no new key
+      // arrives within the hint delay (so a fast typist, or a slow
+      // completer, never adds completion latency to a keystroke)
       if (!tty_read_timeout(env->tty, env->hint_delay, &c)) {
-        // timed-out
+        // timed-out; generate and display the hint
+        eb.hint_pending = false;
+        edit_hint_generate(env, &eb);
         if (sbuf_len(eb.hint) > 0) {
-          // display hint
           edit_refresh(env, &eb);
         }
         c = tty_read(env->tty);
       }
-      else {
-        // clear the pending hint if we got input before the delay expired
-        sbuf_clear(eb.hint);
-        sbuf_clear(eb.hint_help);
-      }
-    }
-    
-    // update terminal in case of a resize
-    if (tty_term_resize_event(env->tty)) {
-      edit_resize(env,&eb);            
+      // else: the keystroke canceled the scheduled hint (cleared in `edit_step`)
     }
 
-    // clear hint only after a potential resize (so resize row calculations are correct)
-    const bool had_hint = (sbuf_len(eb.hint) > 0);
-    sbuf_clear(eb.hint);
-    sbuf_clear(eb.hint_help);
+    // and process it
+    if (edit_step(env, &eb, c)) break;
+  }
 
-    // if the user tries to move into a hint with left-cursor or end, we complete it first
-    if ((c == KEY_RIGHT || c == KEY_END) && had_hint) {
-      edit_generate_completions(env, &eb, true);
-      c = KEY_NONE;      
+  return edit_finish(env, &eb);
+}
+
+// Set up an edit buffer and display the prompt.
+static bool edit_init(ic_env_t* env, editor_t* eb, const char* prompt_text)
+{
+  // all transient buffers for this edit session come from the per-session
+  // arena (reset in O(1) when done); only the resulting line and the history
+  // escape to the regular allocator.
+  if (env->edit_arena == NULL) { env->edit_arena = arena_new(env->mem); }
+  alloc_t* tmem = (env->edit_arena != NULL ? arena_allocator(env->edit_arena) : env->mem);
+
+  memset(eb, 0, sizeof(*eb));
+  eb->mem      = tmem;
+  // the main buffers are pooled in the environment: created on first use and
+  // cleared -- keeping their grown capacity -- for each new edit session, so
+  // a readline call after the first allocates nothing for them
+  if (env->edit_input == NULL) {
+    env->edit_input = sbuf_new(env->mem);
+    if (env->edit_input != NULL) {
+      sbuf_set_gap_buffer(env->edit_input, true);  // the input buffer is edited character-by-character
     }
+  }
+  if (env->edit_extra == NULL)     { env->edit_extra     = sbuf_new(env->mem); }
+  if (env->edit_hint == NULL)      { env->edit_hint      = sbuf_new(env->mem); }
+  if (env->edit_hint_help == NULL) { env->edit_hint_help = sbuf_new(env->mem); }
+  eb->input    = env->edit_input;
+  eb->extra    = env->edit_extra;
+  eb->hint     = env->edit_hint;
+  eb->hint_help= env->edit_hint_help;
+  eb->termw    = term_get_width(env->term);
+  eb->pos      = 0;
+  eb->cur_rows = 1;
+  eb->cur_row  = 0;
+  eb->modified = false;
+  eb->prompt_text   = (prompt_text != NULL ? prompt_text : "");
+  eb->history_idx   = 0;
+  eb->last_code     = KEY_NONE;
+  editstate_init(tmem, &eb->undo);
+  editstate_init(tmem, &eb->redo);
+  rcache_init(&eb->rcache, tmem);
+  if (eb->input==NULL || eb->extra==NULL || eb->hint==NULL || eb->hint_help==NULL) {
+    arena_reset(env->edit_arena);
+    return false;
+  }
+  sbuf_clear(eb->input);
+  sbuf_clear(eb->extra);
+  sbuf_clear(eb->hint);
+  sbuf_clear(eb->hint_help);
 
-    // Operations that may return
-    if (c == KEY_ENTER) {
-      if (!env->singleline_only && eb.pos > 0 && 
-           sbuf_string(eb.input)[eb.pos-1] == env->multiline_eol && 
-            edit_pos_is_at_row_end(env,&eb)) 
-      {
-        // replace line-continuation with newline
-        edit_multiline_eol(env,&eb);        
-      }
-      else {
-        // otherwise done
-        break;
-      }
-    } 
-    else if (c == KEY_CTRL_D) {
-      if (eb.pos == 0 && editor_pos_is_at_end(&eb)) break; // ctrl+D on empty quits with NULL
-      edit_delete_char(env,&eb);     // otherwise it is like delete
-    } 
-    else if (c == KEY_CTRL_C || c == KEY_EVENT_STOP) {
-      break; // ctrl+C or STOP event quits with NULL
+  // caching (the attribute buffers are pooled as well)
+  if (!(env->no_highlight && env->no_bracematch)) {
+    if (env->edit_attrs == NULL)       { env->edit_attrs       = attrbuf_new(env->mem); }
+    if (env->edit_attrs_extra == NULL) { env->edit_attrs_extra = attrbuf_new(env->mem); }
+    eb->attrs = env->edit_attrs;
+    eb->attrs_extra = env->edit_attrs_extra;
+    attrbuf_clear(eb->attrs);
+    attrbuf_clear(eb->attrs_extra);
+    if (env->incremental_highlight) {
+      if (env->edit_attrs_hl == NULL)  { env->edit_attrs_hl    = attrbuf_new(env->mem); }
+      eb->attrs_hl = env->edit_attrs_hl;
+      attrbuf_clear(eb->attrs_hl);
+    }
+  }
+
+  // show prompt
+  edit_write_prompt(env, eb, 0, false);
+
+  // always a history entry for the current input
+  history_push(env->history, "");
+  return true;
+}
+
+// Process one key code; returns true when the line is finished
+// (the terminating code is saved in `eb->last_code` for `edit_finish`).
+static bool edit_step(ic_env_t* env, editor_t* eb, code_t c)
+{
+  // update terminal in case of a resize
+  if (tty_term_resize_event(env->tty)) {
+    edit_resize(env,eb);
+  }
+
+  // clear hint only after a potential resize (so resize row calculations are correct)
+  const bool had_hint = (sbuf_len(eb->hint) > 0);
+  sbuf_clear(eb->hint);
+  sbuf_clear(eb->hint_help);
+  eb->hint_pending = false;  // cancel a scheduled hint generation
+
+  // if the user tries to move into a hint with left-cursor or end, we complete it first
+  if ((c == KEY_RIGHT || c == KEY_END) && had_hint) {
+    edit_generate_completions(env, eb, true);
+    c = KEY_NONE;
+  }
+
+  // Operations that may return
+  if (c == KEY_ENTER) {
+    if (!env->singleline_only && eb->pos > 0 &&
+         sbuf_string(eb->input)[eb->pos-1] == env->multiline_eol &&
+          edit_pos_is_at_row_end(env,eb))
+    {
+      // replace line-continuation with newline
+      edit_multiline_eol(env,eb);
     }
-    else if (c == KEY_ESC) {
-      if (eb.pos == 0 && editor_pos_is_at_end(&eb)) break;  // ESC on empty input returns with empty input
-      edit_delete_all(env,&eb);      // otherwise delete the current input
-      // edit_delete_line(env,&eb);  // otherwise delete the current line
+    else {
+      // otherwise done
+      eb->last_code = c; return true;
+    }
+  }
+  else if (c == KEY_CTRL_D) {
+    if (eb->pos == 0 && editor_pos_is_at_end(eb)) {
+      eb->last_code = c; return true; // ctrl+D on empty quits with NULL
     }
-    else if (c == KEY_BELL /* ^G */) {
-      edit_delete_all(env,&eb);
-      break; // ctrl+G cancels (and returns empty input)
+    edit_delete_char(env,eb);     // otherwise it is like delete
+  }
+  else if (c == KEY_CTRL_C || c == KEY_EVENT_STOP) {
+    eb->last_code = c; return true; // ctrl+C or STOP event quits with NULL
+  }
+  else if (c == KEY_ESC) {
+    if (eb->pos == 0 && editor_pos_is_at_end(eb)) {
+      eb->last_code = c; return true;  // ESC on empty input returns with empty input
     }
+    edit_delete_all(env,eb);      // otherwise delete the current input
+    // edit_delete_line(env,eb);  // otherwise delete the current line
+  }
+  else if (c == KEY_BELL /* ^G */) {
+    edit_delete_all(env,eb);
+    eb->last_code = c; return true; // ctrl+G cancels (and returns empty input)
+  }
 
-    // Editing Operations
-    else switch(c) {
-      // events
-      case KEY_EVENT_RESIZE:  // not used
-        edit_resize(env,&eb);
-        break;
-      case KEY_EVENT_AUTOTAB:
-        edit_generate_completions(env, &eb, true);
-        break;
-
-      // completion, history, help, undo
-      case KEY_TAB:
-      case WITH_ALT('?'):
-        edit_generate_completions(env,&eb,false);
-        break;
-      case KEY_CTRL_R:
-      case KEY_CTRL_S:
-        edit_history_search_with_current_word(env,&eb);
-        break;
-      case KEY_CTRL_P:
-        edit_history_prev(env, &eb);
-        break;
-      case KEY_CTRL_N:
-        edit_history_next(env, &eb);
-        break;
-      case KEY_CTRL_L:
-        edit_clear_screen(env, &eb);
-        break;
-      case KEY_CTRL_Z:
-      case WITH_CTRL('_'):
-        edit_undo_restore(env, &eb);
-        break;
-      case KEY_CTRL_Y:
-        edit_redo_restore(env, &eb);
-        break;
-      case KEY_F1:
-        edit_show_help(env, &eb);
-        break;
-
-      // navigation
-      case KEY_LEFT:
-      case KEY_CTRL_B:
-        edit_cursor_left(env,&eb);
-        break;
-      case KEY_RIGHT:
-      case KEY_CTRL_F:
-        if (eb.pos == sbuf_len(eb.input)) { 
-          edit_generate_completions( env, &eb, false );
-        }
-        else {
-          edit_cursor_right(env,&eb);
-        }
-        break;
-      case KEY_UP:
-        edit_cursor_row_up(env,&eb);
-        break;
-      case KEY_DOWN:
-        edit_cursor_row_down(env,&eb);
-        break;                 
-      case KEY_HOME:
-      case KEY_CTRL_A:
-        edit_cursor_line_start(env,&eb);
-        break;
-      case KEY_END:
-      case KEY_CTRL_E:
-        edit_cursor_line_end(env,&eb);
-        break;
-      case KEY_CTRL_LEFT:
-      case WITH_SHIFT(KEY_LEFT):    
-      case WITH_ALT('b'):
-        edit_cursor_prev_word(env,&eb);
-        break;
-      case KEY_CTRL_RIGHT:
-      case WITH_SHIFT(KEY_RIGHT):      
-      case WITH_ALT('f'):
-        if (eb.pos == sbuf_len(eb.input)) { 
-          edit_generate_completions( env, &eb, false );
-        }
-        else {
-          edit_cursor_next_word(env,&eb);
-        }
-        break;      
-      case KEY_CTRL_HOME:
-      case WITH_SHIFT(KEY_HOME):      
-      case KEY_PAGEUP:
-      case WITH_ALT('<'):
-        edit_cursor_to_start(env,&eb);
-        break;
-      case KEY_CTRL_END:
-      case WITH_SHIFT(KEY_END):      
-      case KEY_PAGEDOWN:
-      case WITH_ALT('>'):
-        edit_cursor_to_end(env,&eb);
-        break;
-      case WITH_ALT('m'):
-        edit_cursor_match_brace(env,&eb);
-        break;
-
-      // deletion
-      case KEY_BACKSP:
-        edit_backspace(env,&eb);
-        break;
-      case KEY_DEL:
-        edit_delete_char(env,&eb);
-        break;
-      case WITH_ALT('d'):
-        edit_delete_to_end_of_word(env,&eb);
-        break;
-      case KEY_CTRL_W:
-        edit_delete_to_start_of_ws_word(env, &eb);
-        break;
-      case WITH_ALT(KEY_DEL):
-      case WITH_ALT(KEY_BACKSP):
-        edit_delete_to_start_of_word(env,&eb);
-        break;      
-      case KEY_CTRL_U:
-        edit_delete_to_start_of_line(env,&eb);
-        break;
-      case KEY_CTRL_K:
-        edit_delete_to_end_of_line(env,&eb);
-        break;
-      case KEY_CTRL_T:
-        edit_swap_char(env,&eb);
-        break;
-
-      // Editing
-      case KEY_SHIFT_TAB:
-      case KEY_LINEFEED: // '\n' (ctrl+J, shift+enter)
-        if (!env->singleline_only) { 
-          edit_insert_char(env, &eb, '\n'); 
-        }
-        break;
-      default: {
-        char chr;
-        unicode_t uchr;
-        if (code_is_ascii_char(c,&chr)) {
-          edit_insert_char(env,&eb,chr);
-        }
-        else if (code_is_unicode(c, &uchr)) {
-          edit_insert_unicode(env,&eb, uchr);
-        }
-        else {
-          debug_msg( "edit: ignore code: 0x%04x\n", c);
-        }
-        break;
+  // Editing Operations
+  else switch(c) {
+    // events
+    case KEY_EVENT_RESIZE:  // not used
+      edit_resize(env,eb);
+      break;
+    case KEY_EVENT_AUTOTAB:
+      edit_generate_completions(env, eb, true);
+      break;
+    case KEY_EVENT_PASTE_START:
+      edit_insert_paste(env, eb);
+      break;
+    case KEY_EVENT_PASTE_END:   // stray end marker; ignore
+      break;
+
+    // completion, history, help, undo
+    case KEY_TAB:
+    case WITH_ALT('?'):
+      edit_generate_completions(env,eb,false);
+      break;
+    case KEY_CTRL_R:
+    case KEY_CTRL_S:
+      edit_history_search_with_current_word(env,eb);
+      break;
+    case KEY_CTRL_P:
+      edit_history_prev(env, eb);
+      break;
+    case KEY_CTRL_N:
+      edit_history_next(env, eb);
+      break;
+    case KEY_CTRL_L:
+      edit_clear_screen(env, eb);
+      break;
+    case KEY_CTRL_Z:
+    case WITH_CTRL('_'):
+      edit_undo_restore(env, eb);
+      break;
+    case KEY_CTRL_Y:
+      edit_redo_restore(env, eb);
+      break;
+    case KEY_F1:
+      edit_show_help(env, eb);
+      break;
+
+    // navigation
+    case KEY_LEFT:
+    case KEY_CTRL_B:
+      edit_cursor_left(env,eb);
+      break;
+    case KEY_RIGHT:
+    case KEY_CTRL_F:
+      if (eb->pos == sbuf_len(eb->input)) {
+        edit_generate_completions( env, eb, false );
+      }
+      else {
+        edit_cursor_right(env,eb);
       }
+      break;
+    case KEY_UP:
+      edit_cursor_row_up(env,eb);
+      break;
+    case KEY_DOWN:
+      edit_cursor_row_down(env,eb);
+      break;
+    case KEY_HOME:
+    case KEY_CTRL_A:
+      edit_cursor_line_start(env,eb);
+      break;
+    case KEY_END:
+    case KEY_CTRL_E:
+      edit_cursor_line_end(env,eb);
+      break;
+    case KEY_CTRL_LEFT:
+    case WITH_SHIFT(KEY_LEFT):
+    case WITH_ALT('b'):
+      edit_cursor_prev_word(env,eb);
+      break;
+    case KEY_CTRL_RIGHT:
+    case WITH_SHIFT(KEY_RIGHT):
+    case WITH_ALT('f'):
+      if (eb->pos == sbuf_len(eb->input)) {
+        edit_generate_completions( env, eb, false );
+      }
+      else {
+        edit_cursor_next_word(env,eb);
+      }
+      break;
+    case KEY_CTRL_HOME:
+    case WITH_SHIFT(KEY_HOME):
+    case KEY_PAGEUP:
+    case WITH_ALT('<'):
+      edit_cursor_to_start(env,eb);
+      break;
+    case KEY_CTRL_END:
+    case WITH_SHIFT(KEY_END):
+    case KEY_PAGEDOWN:
+    case WITH_ALT('>'):
+      edit_cursor_to_end(env,eb);
+      break;
+    case WITH_ALT('m'):
+      edit_cursor_match_brace(env,eb);
+      break;
+
+    // deletion
+    case KEY_BACKSP:
+      edit_backspace(env,eb);
+      break;
+    case KEY_DEL:
+      edit_delete_char(env,eb);
+      break;
+    case WITH_ALT('d'):
+      edit_delete_to_end_of_word(env,eb);
+      break;
+    case KEY_CTRL_W:
+      edit_delete_to_start_of_ws_word(env, eb);
+      break;
+    case WITH_ALT(KEY_DEL):
+    case WITH_ALT(KEY_BACKSP):
+      edit_delete_to_start_of_word(env,eb);
+      break;
+    case KEY_CTRL_U:
+      edit_delete_to_start_of_line(env,eb);
+      break;
+    case KEY_CTRL_K:
+      edit_delete_to_end_of_line(env,eb);
+      break;
+    case KEY_CTRL_T:
+      edit_swap_char(env,eb);
+      break;
+
+    // Editing
+    case KEY_SHIFT_TAB:
+    case KEY_LINEFEED: // '\n' (ctrl+J, shift+enter)
+      if (!env->singleline_only) {
+        edit_insert_char(env, eb, '\n');
+      }
+      break;
+    default: {
+      char chr;
+      unicode_t uchr;
+      if (code_is_ascii_char(c,&chr)) {
+        edit_insert_char(env,eb,chr);
+      }
+      else if (code_is_unicode(c, &uchr)) {
+        edit_insert_unicode(env,eb, uchr);
+      }
+      else {
+        debug_msg( "edit: ignore code: 0x%04x\n", c);
+      }
+      break;
     }
-
   }
+  return false;
+}
+
+// Produce the final result and release the edit session resources.
+static char* edit_finish(ic_env_t* env, editor_t* eb)
+{
+  const code_t c = eb->last_code;
 
   // goto end
-  eb.pos = sbuf_len(eb.input);
+  eb->pos = sbuf_len(eb->input);
 
   // refresh once more but without brace matching
   bool bm = env->no_bracematch;
   env->no_bracematch = true;
-  edit_refresh(env,&eb);
+  edit_refresh(env,eb);
   env->no_bracematch = bm;
-  
-  // save result
-  char* res; 
-  if ((c == KEY_CTRL_D && sbuf_len(eb.input) == 0) || c == KEY_CTRL_C || c == KEY_EVENT_STOP) {
+
+  // save result (in the regular allocator as it escapes the edit session)
+  char* res;
+  if ((c == KEY_CTRL_D && sbuf_len(eb->input) == 0) || c == KEY_CTRL_C || c == KEY_EVENT_STOP) {
     res = NULL;
   }
   else if (!tty_is_utf8(env->tty)) {
-    res = sbuf_strdup_from_utf8(eb.input);
+    char* tres = sbuf_strdup_from_utf8(eb->input);  // allocated by the (pooled) input buffer from the regular allocator
+    res = mem_strdup(env->mem, tres);
+    mem_free(env->mem, tres);
   }
   else {
-    res = sbuf_strdup(eb.input);
+    res = mem_strdup(env->mem, sbuf_string(eb->input));
   }
 
   // update history
-  history_update(env->history, sbuf_string(eb.input));
-  if (res == NULL || sbuf_len(eb.input) <= 1) { ic_history_remove_last(); } // no empty or single-char entries
+  history_update(env->history, sbuf_string(eb->input));
+  if (res == NULL || sbuf_len(eb->input) <= 1) { history_remove_last(env->history); } // no empty or single-char entries
   history_save(env->history);
 
-  // free resources 
-  editstate_done(env->mem, &eb.undo);
-  editstate_done(env->mem, &eb.redo);
-  attrbuf_free(eb.attrs);
-  attrbuf_free(eb.attrs_extra);
-  sbuf_free(eb.input);
-  sbuf_free(eb.extra);
-  sbuf_free(eb.hint);
-  sbuf_free(eb.hint_help);
+  // free resources; the pooled buffers stay warm in the environment
+  editstate_done(&eb->undo);
+  editstate_done(&eb->redo);
+  rcache_done(&eb->rcache);
+  arena_reset(env->edit_arena);
 
   return res;
 }
 
+//-------------------------------------------------------------
+// Async (poll based) edit session; see `ic_readline_start`
+//-------------------------------------------------------------
+
+ic_private bool ic_editline_start(ic_env_t* env, const char* prompt_text) {
+  if (env->async_edit != NULL) return false;  // already an active session
+  tty_start_raw(env->tty);
+  term_start_raw(env->term);
+  if (env->edit_arena == NULL) { env->edit_arena = arena_new(env->mem); }
+  alloc_t* tmem = (env->edit_arena != NULL ? arena_allocator(env->edit_arena) : env->mem);
+  editor_t* eb = mem_zalloc_tp(tmem, editor_t);
+  // the prompt is duplicated as the session outlives this call
+  if (eb == NULL || !edit_init(env, eb, mem_strdup(tmem, prompt_text))) {
+    term_end_raw(env->term, false);
+    tty_end_raw(env->tty);
+    arena_reset(env->edit_arena);
+    return false;
+  }
+  env->async_edit = eb;
+  term_flush(env->term);
+  return true;
+}
+
+ic_private bool ic_editline_poll(ic_env_t* env, char** line) {
+  if (line != NULL) { *line = NULL; }
+  editor_t* eb = env->async_edit;
+  if (eb == NULL) return false;
+  code_t c;
+  while (tty_read_timeout(env->tty, 0, &c)) {  // process only already available input
+    if (edit_step(env, eb, c)) {
+      char* res = edit_finish(env, eb);        // also resets the arena holding `eb`
+      env->async_edit = NULL;
+      term_end_raw(env->term, false);
+      tty_end_raw(env->tty);
+      term_writeln(env->term, "");
+      term_flush(env->term);
+      if (line != NULL) { *line = res; }
+      else { mem_free(env->mem, res); }
+      return true;
+    }
+  }
+  term_flush(env->term);
+  return false;
+}
+
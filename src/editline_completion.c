@@ -109,12 +109,17 @@ static void edit_completion_menu(ic_env_t* env, editor_t* eb, bool more_availabl
   ssize_t selected = (env->complete_nopreview ? 0 : -1); // select first or none
   ssize_t percolumn = count;
 
+  // measure only the entries of the first page, and only once
+  // (not again on every menu keypress)
+  const ssize_t colwidth3 = 3 + edit_completions_max_width(env, (count > 9 ? 9 : count));
+  const ssize_t colwidth2 = 3 + edit_completions_max_width(env, (count > 8 ? 8 : count));
+
 again:
   // show first 9 (or 8) completions
   sbuf_clear(eb->extra);
   ssize_t twidth = term_get_width(env->term) - 1;
   ssize_t colwidth;
-  if (count > 3 && ((colwidth = 3 + edit_completions_max_width(env, 9))*3 + 2*2) < twidth) {
+  if (count > 3 && ((colwidth = colwidth3)*3 + 2*2) < twidth) {
     // display as a 3 column block
     count_displayed = (count > 9 ? 9 : count);
     percolumn = 3;
@@ -123,7 +128,7 @@ again:
       editor_append_completion3(env, eb, colwidth, rw, percolumn+rw, (2*percolumn)+rw, selected);
     }
   }
-  else if (count > 4 && ((colwidth = 3 + edit_completions_max_width(env, 8))*2 + 2) < twidth) {
+  else if (count > 4 && ((colwidth = colwidth2)*2 + 2) < twidth) {
     // display as a 2 column block if some entries are too wide for three columns
     count_displayed = (count > 8 ? 8 : count);
     percolumn = (count_displayed <= 6 ? 3 : 4);
@@ -220,6 +225,7 @@ again:
       // generate all entries (up to the max (= 1000))
       count = completions_generate(env, env->completions, sbuf_string(eb->input), eb->pos, IC_MAX_COMPLETIONS_TO_SHOW);
     }
+    completions_sort(env->completions);  // only the first page was sorted up front
     rowcol_t rc;
     edit_get_rowcol(env,eb,&rc);
     edit_clear(env,eb);
@@ -271,7 +277,7 @@ static void edit_generate_completions(ic_env_t* env, editor_t* eb, bool autotab)
     if (!more_available) { 
       edit_complete_longest_prefix(env,eb);
     }    
-    completions_sort(env->completions);
-    edit_completion_menu( env, eb, more_available);    
+    completions_sort_top(env->completions, 9);  // the menu displays at most one page of 9
+    edit_completion_menu( env, eb, more_available);
   }
 }
@@ -21,6 +21,9 @@
 // Environment
 //-------------------------------------------------------------
 
+struct editor_s;   // the editor state of an edit session (in editline.c)
+struct dircache_s; // cached directory listings for filename completion (in completers.c)
+
 struct ic_env_s {
   alloc_t*        mem;              // potential custom allocator
   ic_env_t*       next;             // next environment (used for proper deallocation)
@@ -28,7 +31,19 @@ struct ic_env_s {
   tty_t*          tty;              // keyboard (NULL if stdin is a pipe, file, etc)
   completions_t*  completions;      // current completions
   history_t*      history;          // edit history
+  arena_t*        edit_arena;       // arena for transient per-readline allocations (reset after each call)
+  struct editor_s* async_edit;      // active asynchronous edit session (see `ic_readline_start`)
+  // pooled editor buffers: created on first use and retained warm
+  // (capacity intact) across readline calls; cleared in O(1) per call
+  stringbuf_t*    edit_input;       // edited input (gap buffer)
+  stringbuf_t*    edit_extra;       // extra output under the input (completion menu etc.)
+  stringbuf_t*    edit_hint;        // inline hint
+  stringbuf_t*    edit_hint_help;   // help line for the hint
+  attrbuf_t*      edit_attrs;       // highlight attributes for the input
+  attrbuf_t*      edit_attrs_extra; // highlight attributes for the extra output
+  attrbuf_t*      edit_attrs_hl;    // highlighter-only attributes (incremental highlighting)
   bbcode_t*       bbcode;           // print with bbcodes
+  struct dircache_s* dircache;      // cached directory listings (created on demand)
   const char*     prompt_marker;    // the prompt marker (defaults to "> ")
   const char*     cprompt_marker;   // prompt marker for continuation lines (defaults to `prompt_marker`)
   ic_highlight_fun_t* highlighter;  // highlight callback
@@ -46,12 +61,17 @@ struct ic_env_s {
   bool            no_hint;          // allow hinting?
   bool            no_highlight;     // enable highlighting?
   bool            no_bracematch;    // enable brace matching?
+  bool            incremental_highlight; // rerun the highlighter only from the edited line? (opt-in)
   bool            no_autobrace;     // enable automatic brace insertion?
   bool            no_lscolors;      // use LSCOLORS/LS_COLORS to colorize file name completions?
   long            hint_delay;       // delay before displaying a hint in milliseconds
 };
 
 ic_private char*        ic_editline(ic_env_t* env, const char* prompt_text);
+ic_private bool         ic_editline_start(ic_env_t* env, const char* prompt_text);
+ic_private bool         ic_editline_poll(ic_env_t* env, char** line);
+
+ic_private void         dircache_free(struct dircache_s* dc);   // in completers.c
 
 ic_private ic_env_t*    ic_get_env(void);
 ic_private const char*  ic_env_get_auto_braces(ic_env_t* env);
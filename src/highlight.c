@@ -18,29 +18,75 @@
 
 struct ic_highlight_env_s {
   attrbuf_t*    attrs;
-  const char*   input;   
-  ssize_t       input_len;     
+  ssize_t       attr_ofs;     // offset of `input` in `attrs` (used for incremental highlighting)
+  const char*   input;
+  ssize_t       input_len;
   bbcode_t*     bbcode;
   alloc_t*      mem;
   ssize_t       cached_upos;  // cached unicode position
   ssize_t       cached_cpos;  // corresponding utf-8 byte position
 };
 
-
-ic_private void highlight( alloc_t* mem, bbcode_t* bb, const char* s, attrbuf_t* attrs, ic_highlight_fun_t* highlighter, void* arg ) {
-  const ssize_t len = ic_strlen(s);
-  if (len <= 0) return;
-  attrbuf_set_at(attrs,0,len,attr_none()); // fill to length of s
+static void highlight_run( alloc_t* mem, bbcode_t* bb, const char* s, ssize_t len, attrbuf_t* attrs, ssize_t attr_ofs, ic_highlight_fun_t* highlighter, void* arg ) {
+  attrbuf_set_at(attrs,attr_ofs,len,attr_none()); // fill to length of s
   if (highlighter != NULL) {
     ic_highlight_env_t henv;
     henv.attrs = attrs;
-    henv.input = s;     
+    henv.attr_ofs = attr_ofs;
+    henv.input = s;
     henv.input_len = len;
     henv.bbcode = bb;
     henv.mem = mem;
     henv.cached_cpos = 0;
     henv.cached_upos = 0;
-    (*highlighter)( &henv, s, arg );    
+    ic_stats_timed_begin();
+    (*highlighter)( &henv, s, arg );
+    ic_stats_timed_end(highlight_count, highlight_nsecs);
+  }
+}
+
+ic_private void highlight( alloc_t* mem, bbcode_t* bb, const char* s, attrbuf_t* attrs, ic_highlight_fun_t* highlighter, void* arg ) {
+  const ssize_t len = ic_strlen(s);
+  if (len <= 0) return;
+  highlight_run( mem, bb, s, len, attrs, 0, highlighter, arg );
+}
+
+// Incremental highlighting (opt-in, see `ic_enable_incremental_highlight`):
+// keep the highlighter output for the previous input in `cache` and, after an
+// edit, rerun the highlighter only from a safe restart point -- the start of
+// the line containing the first edited byte -- splicing the fresh attributes
+// over the cached tail. The (possibly reused) cache is then copied into `attrs`.
+ic_private void highlight_incremental( alloc_t* mem, bbcode_t* bb, stringbuf_t* input, attrbuf_t* attrs, attrbuf_t* cache,
+                                        ic_highlight_fun_t* highlighter, void* arg )
+{
+  const char* s = sbuf_string(input);
+  const ssize_t len = sbuf_len(input);
+  ssize_t edited = sbuf_edited_at(input);
+  if (edited >= 0 || attrbuf_len(cache) != len) {
+    if (edited < 0 || edited > len) { edited = len; }
+    // safe restart point: the start of the line enclosing the first edit
+    ssize_t restart = edited;
+    while (restart > 0 && s[restart-1] != '\n') { restart--; }
+    // drop the cached attributes from the restart point on, and rerun the
+    // highlighter over the tail only
+    if (attrbuf_len(cache) > restart) {
+      attrbuf_delete_at(cache, restart, attrbuf_len(cache) - restart);
+    }
+    if (len > restart) {
+      highlight_run( mem, bb, s + restart, len - restart, cache, restart, highlighter, arg );
+    }
+    sbuf_edit_reset(input);
+  }
+  // copy the cached attributes into the display buffer
+  attrbuf_clear(attrs);
+  attrbuf_iter_t iter;
+  attrbuf_iter_start(cache, 0, &iter);
+  attr_t attr;
+  ssize_t count;
+  ssize_t pos = 0;
+  while (attrbuf_iter_next(&iter, &attr, &count)) {
+    attrbuf_set_at(attrs, pos, count, attr);
+    pos += count;
   }
 }
 
@@ -100,7 +146,7 @@ static void highlight_attr(ic_highlight_env_t* henv, ssize_t pos, ssize_t count,
   if (henv==NULL) return;
   pos_adjust(henv,&pos,&count);
   if (pos < 0 || count <= 0) return;
-  attrbuf_update_at(henv->attrs, pos, count, attr);
+  attrbuf_update_at(henv->attrs, henv->attr_ofs + pos, count, attr);
 }
 
 ic_public void ic_highlight(ic_highlight_env_t* henv, long pos, long count, const char* style ) {
@@ -119,7 +165,7 @@ ic_public void ic_highlight_formatted(ic_highlight_env_t* henv, const char* s, c
       debug_msg("highlight: formatted string content differs from the original input:\n  original: %s\n  formatted: %s\n", s, fmt);
     }
     for( ssize_t i = 0; i < len; i++) {
-      attrbuf_update_at(henv->attrs, i, 1, attrbuf_attr_at(attrs,i));
+      attrbuf_update_at(henv->attrs, henv->attr_ofs + i, 1, attrbuf_attr_at(attrs,i));
     }
   }
   sbuf_free(out);
@@ -12,12 +12,15 @@
 #include "attr.h"
 #include "term.h"
 #include "bbcode.h"
+#include "stringbuf.h"
 
 //-------------------------------------------------------------
 // Syntax highlighting
 //-------------------------------------------------------------
 
 ic_private void highlight( alloc_t* mem, bbcode_t* bb, const char* s, attrbuf_t* attrs, ic_highlight_fun_t* highlighter, void* arg );
+ic_private void highlight_incremental( alloc_t* mem, bbcode_t* bb, stringbuf_t* input, attrbuf_t* attrs, attrbuf_t* cache,
+                                        ic_highlight_fun_t* highlighter, void* arg );
 ic_private void highlight_match_braces(const char* s, attrbuf_t* attrs, ssize_t cursor_pos, const char* braces, attr_t match_attr, attr_t error_attr);
 ic_private ssize_t find_matching_brace(const char* s, ssize_t cursor_pos, const char* braces, bool* is_balanced);
 
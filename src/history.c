@@ -5,9 +5,16 @@
   found in the "LICENSE" file at the root of this distribution.
 -----------------------------------------------------------------------------*/
 #include <stdio.h>
-#include <string.h>  
+#include <string.h>
 #include <sys/stat.h>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#endif
+
 #include "../include/isocline.h"
 #include "common.h"
 #include "history.h"
@@ -15,15 +22,54 @@
 
 #define IC_MAX_HISTORY (200)
 
+// A history entry. Entries that were loaded from the history file keep a
+// span into the loaded (memory mapped) file and are only unescaped into an
+// allocated string on first access; newly pushed entries own their string
+// right away.
+typedef struct hentry_s {
+  const char* text;     // decoded entry (owned), or NULL if not decoded yet
+  const char* raw;      // escaped line in the loaded history file (into `fbuf`), or NULL
+  ssize_t     raw_len;  // length of the raw line
+  bool        saved;    // is the entry already persisted in the history file?
+} hentry_t;
+
 struct history_s {
   ssize_t  count;              // current number of entries in use
-  ssize_t  len;                // size of elems 
-  const char** elems;         // history items (up to count)
-  const char*  fname;         // history file
+  ssize_t  len;                // size of elems
+  hentry_t* elems;             // history items (up to count)
+  const char*  fname;          // history file
   alloc_t* mem;
   bool     allow_duplicates;   // allow duplicate entries?
+  bool     needs_rewrite;      // can we append on save, or is a full rewrite needed?
+  // the loaded history file; raw entry spans point into this buffer
+  char*    fbuf;               // mapped (or heap allocated) file content
+  size_t   fbuf_size;
+  bool     fbuf_mmapped;       // was `fbuf` created through mmap?
+  // trigram search index: per trigram bucket a bitmap of the entries
+  // that contain it (see `history_search`)
+  uint32_t* gram_bits;         // IC_HIDX_BUCKETS bitmaps of `bitmap_words` words each
+  ssize_t   bitmap_words;
+  bool      index_valid;
+  // duplicate detection: open-addressed map from entry text to its index
+  // so a push does not strcmp every entry (see `history_push`)
+  ssize_t*  dedup;             // IC_HDEDUP_SLOTS slots; -1 is empty, -2 a removed entry
+  ssize_t   dedup_used;        // occupied slots (including removed ones)
+  bool      dedup_valid;
+  // bytes of the history file already read or written by us; entries
+  // appended past this by sibling processes are merged in on save
+  ssize_t   fsize;
 };
 
+static void history_unload_file(history_t* h);
+static int  history_file_lock(history_t* h, bool exclusive);
+static void history_file_unlock(int lockfd);
+static void history_index_invalidate(history_t* h);
+static void history_index_add(history_t* h, ssize_t idx, const char* text);
+static void history_dedup_invalidate(history_t* h);
+static void history_dedup_ensure(history_t* h);
+static void history_dedup_insert(history_t* h, const char* text, ssize_t idx);
+static void history_dedup_remove(history_t* h, ssize_t idx);
+
 ic_private history_t* history_new(alloc_t* mem) {
   history_t* h = mem_zalloc_tp(mem,history_t);
   h->mem = mem;
@@ -38,6 +84,11 @@ ic_private void history_free(history_t* h) {
     h->elems = NULL;
     h->len = 0;
   }
+  history_unload_file(h);
+  mem_free(h->mem, h->gram_bits);
+  h->gram_bits = NULL;
+  mem_free(h->mem, h->dedup);
+  h->dedup = NULL;
   mem_free(h->mem, h->fname);
   h->fname = NULL;
   mem_free(h->mem, h); // free ourselves
@@ -53,6 +104,152 @@ ic_private ssize_t  history_count(const history_t* h) {
   return h->count;
 }
 
+//-------------------------------------------------------------
+// lazy decoding of entries loaded from the history file
+//-------------------------------------------------------------
+
+static char from_xdigit( int c ) {
+  if (c >= '0' && c <= '9') return (char)(c - '0');
+  if (c >= 'A' && c <= 'F') return (char)(10 + (c - 'A'));
+  if (c >= 'a' && c <= 'f') return (char)(10 + (c - 'a'));
+  return 0;
+}
+
+static char to_xdigit( uint8_t c ) {
+  if (c <= 9) return ((char)c + '0');
+  if (c >= 10 && c <= 15) return ((char)c - 10 + 'A');
+  return '0';
+}
+
+static bool ic_isxdigit( int c ) {
+  return ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || (c >= '0' && c <= '9'));
+}
+
+// unescape a raw history file line
+static char* history_decode_entry( history_t* h, const char* s, ssize_t len ) {
+  stringbuf_t* sbuf = sbuf_new(h->mem);
+  if (sbuf == NULL) return NULL;
+  for (ssize_t i = 0; i < len; i++) {
+    char c = s[i];
+    if (c == '\\' && i+1 < len) {
+      c = s[++i];
+      if (c == 'n')       { sbuf_append(sbuf,"\n"); }
+      else if (c == 'r')  { /* ignore */ }  // sbuf_append(sbuf,"\r");
+      else if (c == 't')  { sbuf_append(sbuf,"\t"); }
+      else if (c == '\\') { sbuf_append(sbuf,"\\"); }
+      else if (c == 'x' && i+2 < len && ic_isxdigit(s[i+1]) && ic_isxdigit(s[i+2])) {
+        char chr = from_xdigit(s[i+1])*16 + from_xdigit(s[i+2]);
+        sbuf_append_char(sbuf,chr);
+        i += 2;
+      }
+      else break; // error
+    }
+    else sbuf_append_char(sbuf,c);
+  }
+  return sbuf_free_dup(sbuf);
+}
+
+// get the decoded text of an entry; decodes from the loaded file on first access
+static const char* history_entry_text( history_t* h, ssize_t idx ) {
+  if (idx < 0 || idx >= h->count) return NULL;
+  hentry_t* e = &h->elems[idx];
+  if (e->text == NULL && e->raw != NULL) {
+    e->text = history_decode_entry(h, e->raw, e->raw_len);
+  }
+  return (e->text != NULL ? e->text : "");
+}
+
+//-------------------------------------------------------------
+// duplicate detection
+// An open-addressed map from the entry text to its index so a
+// push checks for an older duplicate in O(1) instead of
+// strcmp-ing every entry. Only the indices are stored (the
+// text is read from the entry itself); the map is built on
+// demand and kept in sync as entries are added and removed.
+//-------------------------------------------------------------
+
+#define IC_HDEDUP_SLOTS  (512)   // power of two, > (4/3)*IC_MAX_HISTORY so a rebuild always fits
+
+static uint32_t hdedup_hash( const char* s ) {
+  // FNV-1a
+  uint32_t h = 2166136261U;
+  while (*s != 0) {
+    h = (h ^ (uint8_t)(*s)) * 16777619U;
+    s++;
+  }
+  return h;
+}
+
+static void history_dedup_invalidate( history_t* h ) {
+  h->dedup_valid = false;
+}
+
+// insert an entry; duplicate texts simply occupy multiple slots
+static void history_dedup_insert( history_t* h, const char* text, ssize_t idx ) {
+  if (!h->dedup_valid || text == NULL) return;
+  if (4*(h->dedup_used + 1) > 3*IC_HDEDUP_SLOTS) {
+    // mostly removed slots; rebuild to reclaim them (this re-inserts `idx` too)
+    history_dedup_invalidate(h);
+    history_dedup_ensure(h);
+    return;
+  }
+  ssize_t i = (ssize_t)(hdedup_hash(text) & (IC_HDEDUP_SLOTS - 1));
+  while (h->dedup[i] >= 0) {
+    i = (i + 1) & (IC_HDEDUP_SLOTS - 1);
+  }
+  if (h->dedup[i] == -1) { h->dedup_used++; }  // not reusing a removed slot
+  h->dedup[i] = idx;
+}
+
+static void history_dedup_ensure( history_t* h ) {
+  if (h->dedup_valid) return;
+  if (h->dedup == NULL) {
+    h->dedup = mem_malloc_tp_n(h->mem, ssize_t, IC_HDEDUP_SLOTS);
+    if (h->dedup == NULL) return;
+  }
+  for (ssize_t i = 0; i < IC_HDEDUP_SLOTS; i++) { h->dedup[i] = -1; }
+  h->dedup_used = 0;
+  h->dedup_valid = true;
+  assert(h->count <= IC_HDEDUP_SLOTS/2);
+  for (ssize_t i = 0; i < h->count; i++) {
+    history_dedup_insert(h, history_entry_text(h,i), i);
+  }
+}
+
+// find the index of an entry with the given text (-1 if not present)
+static ssize_t history_dedup_lookup( history_t* h, const char* text ) {
+  if (!h->dedup_valid || text == NULL) return -1;
+  ssize_t i = (ssize_t)(hdedup_hash(text) & (IC_HDEDUP_SLOTS - 1));
+  while (h->dedup[i] != -1) {
+    if (h->dedup[i] >= 0 && strcmp(history_entry_text(h, h->dedup[i]), text) == 0) {
+      return h->dedup[i];
+    }
+    i = (i + 1) & (IC_HDEDUP_SLOTS - 1);  // skip removed slots (-2)
+  }
+  return -1;
+}
+
+// remove the entry at `idx` from the map (call before its text is freed)
+static void history_dedup_remove( history_t* h, ssize_t idx ) {
+  if (!h->dedup_valid) return;
+  ssize_t i = (ssize_t)(hdedup_hash(history_entry_text(h,idx)) & (IC_HDEDUP_SLOTS - 1));
+  while (h->dedup[i] != -1) {
+    if (h->dedup[i] == idx) {
+      h->dedup[i] = -2;  // leave a removed marker so probe chains stay intact
+      return;
+    }
+    i = (i + 1) & (IC_HDEDUP_SLOTS - 1);
+  }
+}
+
+// adjust the indices after the entry at `idx` was deleted (entries shift down)
+static void history_dedup_shift( history_t* h, ssize_t idx ) {
+  if (!h->dedup_valid) return;
+  for (ssize_t i = 0; i < IC_HDEDUP_SLOTS; i++) {
+    if (h->dedup[i] > idx) { h->dedup[i]--; }
+  }
+}
+
 //-------------------------------------------------------------
 // push/clear
 //-------------------------------------------------------------
@@ -67,31 +264,54 @@ ic_private bool history_update( history_t* h, const char* entry ) {
 
 static void history_delete_at( history_t* h, ssize_t idx ) {
   if (idx < 0 || idx >= h->count) return;
-  mem_free(h->mem, h->elems[idx]);
+  if (h->elems[idx].saved) {
+    h->needs_rewrite = true;  // the file still contains this entry
+  }
+  history_dedup_remove(h, idx);   // before the text is freed
+  mem_free(h->mem, h->elems[idx].text);
   for(ssize_t i = idx+1; i < h->count; i++) {
     h->elems[i-1] = h->elems[i];
   }
   h->count--;
+  history_index_invalidate(h);  // entry indices shifted
+  history_dedup_shift(h, idx);
 }
 
 ic_private bool history_push( history_t* h, const char* entry ) {
   if (h->len <= 0 || entry==NULL)  return false;
   // remove any older duplicate
   if (!h->allow_duplicates) {
-    for( int i = 0; i < h->count; i++) {
-      if (strcmp(h->elems[i],entry) == 0) {
-        history_delete_at(h,i);
+    history_dedup_ensure(h);
+    if (h->dedup_valid) {
+      ssize_t dup;
+      while ((dup = history_dedup_lookup(h, entry)) >= 0) {
+        history_delete_at(h, dup);
+      }
+    }
+    else {
+      // no memory for the map; fall back to a scan
+      for( ssize_t i = 0; i < h->count; i++) {
+        if (strcmp(history_entry_text(h,i),entry) == 0) {
+          history_delete_at(h,i);
+        }
       }
     }
   }
   // insert at front
   if (h->count == h->len) {
     // delete oldest entry
-    history_delete_at(h,0);    
+    history_delete_at(h,0);
   }
   assert(h->count < h->len);
-  h->elems[h->count] = mem_strdup(h->mem,entry);
+  h->elems[h->count].text    = mem_strdup(h->mem,entry);
+  h->elems[h->count].raw     = NULL;
+  h->elems[h->count].raw_len = 0;
+  h->elems[h->count].saved   = false;
   h->count++;
+  if (h->index_valid) {
+    history_index_add(h, h->count-1, entry);  // keep the search index current
+  }
+  history_dedup_insert(h, h->elems[h->count-1].text, h->count-1);
   return true;
 }
 
@@ -99,11 +319,17 @@ ic_private bool history_push( history_t* h, const char* entry ) {
 static void history_remove_last_n( history_t* h, ssize_t n ) {
   if (n <= 0) return;
   if (n > h->count) n = h->count;
+  if (n == h->count) { history_dedup_invalidate(h); }  // wholesale clear; no need to remove one by one
   for( ssize_t i = h->count - n; i < h->count; i++) {
-    mem_free( h->mem, h->elems[i] );
+    if (h->elems[i].saved) { h->needs_rewrite = true; }
+    history_dedup_remove(h, i);
+    mem_free( h->mem, h->elems[i].text );
   }
   h->count -= n;
-  assert(h->count >= 0);    
+  assert(h->count >= 0);
+  // note: the search index stays valid as the remaining entries keep their
+  // indices; bits of the removed entries are stale but only ever cause a
+  // candidate to be verified (and rejected) by the actual substring match.
 }
 
 ic_private void history_remove_last(history_t* h) {
@@ -114,22 +340,98 @@ ic_private void history_clear(history_t* h) {
   history_remove_last_n( h, h->count );
 }
 
-ic_private const char* history_get( const history_t* h, ssize_t n ) {
+ic_private const char* history_get( history_t* h, ssize_t n ) {
   if (n < 0 || n >= h->count) return NULL;
-  return h->elems[h->count - n - 1];
+  return history_entry_text(h, h->count - n - 1);
+}
+
+//-------------------------------------------------------------
+// search index
+// Trigram posting lists: for each trigram (hashed to a bucket)
+// keep a bitmap of the entries that contain it. An incremental
+// search intersects the bitmaps of the trigrams in the search
+// string so only candidate entries are decoded and verified,
+// instead of scanning every entry on each search keystroke.
+// The index is built once on the first search and updated on
+// each push.
+//-------------------------------------------------------------
+
+#define IC_HIDX_BUCKETS      (512)
+#define IC_HIDX_BITMAP_WORDS ((IC_MAX_HISTORY + 31)/32)
+
+static uint32_t hidx_bucket( const char* s ) {
+  // FNV-1a over the 3 trigram bytes
+  uint32_t x = 2166136261u;
+  x = (x ^ (uint8_t)s[0]) * 16777619u;
+  x = (x ^ (uint8_t)s[1]) * 16777619u;
+  x = (x ^ (uint8_t)s[2]) * 16777619u;
+  return (x % IC_HIDX_BUCKETS);
+}
+
+static void history_index_invalidate( history_t* h ) {
+  h->index_valid = false;
+}
+
+static void history_index_add( history_t* h, ssize_t idx, const char* text ) {
+  if (h->gram_bits == NULL || text == NULL || idx < 0 || idx >= h->len) return;
+  const ssize_t n = ic_strlen(text);
+  for (ssize_t i = 0; i + 3 <= n; i++) {
+    uint32_t* bm = h->gram_bits + (hidx_bucket(text + i) * (uint32_t)h->bitmap_words);
+    bm[idx/32] |= ((uint32_t)1 << (idx%32));
+  }
+}
+
+static void history_index_ensure( history_t* h ) {
+  if (h->index_valid) return;
+  if (h->gram_bits == NULL) {
+    h->bitmap_words = IC_HIDX_BITMAP_WORDS;
+    h->gram_bits = mem_zalloc_tp_n(h->mem, uint32_t, IC_HIDX_BUCKETS * IC_HIDX_BITMAP_WORDS);
+    if (h->gram_bits == NULL) return;
+  }
+  else {
+    ic_memset(h->gram_bits, 0, IC_HIDX_BUCKETS * IC_HIDX_BITMAP_WORDS * ssizeof(uint32_t));
+  }
+  for (ssize_t i = 0; i < h->count; i++) {
+    history_index_add(h, i, history_entry_text(h,i));
+  }
+  h->index_valid = true;
+}
+
+// intersect the posting bitmaps for all trigrams in `search`;
+// returns false if the index cannot be used
+static bool history_index_candidates( history_t* h, const char* search, ssize_t n, uint32_t* cand ) {
+  if (n < 3) return false;  // too short for trigrams; scan linearly
+  history_index_ensure(h);
+  if (!h->index_valid) return false;
+  ic_memset(cand, 0xFF, IC_HIDX_BITMAP_WORDS * ssizeof(uint32_t));
+  for (ssize_t i = 0; i + 3 <= n; i++) {
+    const uint32_t* bm = h->gram_bits + (hidx_bucket(search + i) * (uint32_t)h->bitmap_words);
+    for (ssize_t w = 0; w < IC_HIDX_BITMAP_WORDS; w++) {
+      cand[w] &= bm[w];
+    }
+  }
+  return true;
+}
+
+static bool history_is_candidate( const uint32_t* cand, ssize_t idx ) {
+  return ((cand[idx/32] & ((uint32_t)1 << (idx%32))) != 0);
 }
 
-ic_private bool history_search( const history_t* h, ssize_t from /*including*/, const char* search, bool backward, ssize_t* hidx, ssize_t* hpos ) {
+ic_private bool history_search( history_t* h, ssize_t from /*including*/, const char* search, bool backward, ssize_t* hidx, ssize_t* hpos ) {
+  uint32_t cand[IC_HIDX_BITMAP_WORDS];
+  const bool use_index = history_index_candidates(h, search, ic_strlen(search), cand);
   const char* p = NULL;
   ssize_t i;
   if (backward) {
     for( i = from; i < h->count; i++ ) {
+      if (use_index && !history_is_candidate(cand, h->count - i - 1)) continue;
       p = strstr( history_get(h,i), search);
       if (p != NULL) break;
     }
   }
   else {
     for( i = from; i >= 0; i-- ) {
+      if (use_index && !history_is_candidate(cand, h->count - i - 1)) continue;
       p = strstr( history_get(h,i), search);
       if (p != NULL) break;
     }
@@ -141,7 +443,7 @@ ic_private bool history_search( const history_t* h, ssize_t from /*including*/,
 }
 
 //-------------------------------------------------------------
-// 
+//
 //-------------------------------------------------------------
 
 ic_private void history_load_from(history_t* h, const char* fname, long max_entries ) {
@@ -152,7 +454,7 @@ ic_private void history_load_from(history_t* h, const char* fname, long max_entr
     return;
   }
   if (max_entries < 0 || max_entries > IC_MAX_HISTORY) max_entries = IC_MAX_HISTORY;
-  h->elems = (const char**)mem_zalloc_tp_n(h->mem, char*, max_entries );
+  h->elems = mem_zalloc_tp_n(h->mem, hentry_t, max_entries );
   if (h->elems == NULL) return;
   h->len = max_entries;
   history_load(h);
@@ -163,51 +465,150 @@ ic_private void history_load_from(history_t* h, const char* fname, long max_entr
 
 //-------------------------------------------------------------
 // save/load history to file
+//
+// The history file is loaded through a read-only mmap (with a
+// plain read as fallback) and only indexed into line spans; the
+// entries themselves are unescaped lazily on first access so
+// startup cost is independent of entry sizes.
+//
+// The file may be shared between processes: all access goes
+// through an advisory lock on a sidecar `<fname>.lock` file, a
+// save appends only the new entries and first merges in what
+// sibling processes appended since we last read the file, and
+// an oversized file is compacted by writing a fresh copy that
+// is renamed over the old one.
 //-------------------------------------------------------------
 
-static char from_xdigit( int c ) {
-  if (c >= '0' && c <= '9') return (char)(c - '0');
-  if (c >= 'A' && c <= 'F') return (char)(10 + (c - 'A'));
-  if (c >= 'a' && c <= 'f') return (char)(10 + (c - 'a'));
-  return 0;
+// Advisory cross-process lock. A sidecar `<fname>.lock` file is
+// flock'ed so sibling processes serialize their appends and
+// compactions (the history file itself can be replaced by a
+// compaction so it cannot serve as the lock). Returns the lock
+// file descriptor, or -1 if locking is unavailable.
+static int history_file_lock( history_t* h, bool exclusive ) {
+  #if !defined(_WIN32)
+  if (h->fname == NULL) return -1;
+  const ssize_t n = ic_strlen(h->fname);
+  char* lname = mem_malloc_tp_n(h->mem, char, n + 6);
+  if (lname == NULL) return -1;
+  strcpy(lname, h->fname);
+  strcpy(lname + n, ".lock");
+  const int fd = open(lname, O_CREAT|O_RDWR, S_IRUSR|S_IWUSR);
+  mem_free(h->mem, lname);
+  if (fd < 0) return -1;
+  if (flock(fd, (exclusive ? LOCK_EX : LOCK_SH)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+  #else
+  ic_unused(h); ic_unused(exclusive);
+  return -1;
+  #endif
 }
 
-static char to_xdigit( uint8_t c ) {
-  if (c <= 9) return ((char)c + '0');
-  if (c >= 10 && c <= 15) return ((char)c - 10 + 'A');
-  return '0';
+static void history_file_unlock( int lockfd ) {
+  #if !defined(_WIN32)
+  if (lockfd >= 0) {
+    flock(lockfd, LOCK_UN);
+    close(lockfd);
+  }
+  #else
+  ic_unused(lockfd);
+  #endif
 }
 
-static bool ic_isxdigit( int c ) {
-  return ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || (c >= '0' && c <= '9'));
+static void history_unload_file(history_t* h) {
+  if (h->fbuf == NULL) return;
+  #if !defined(_WIN32)
+  if (h->fbuf_mmapped) {
+    munmap(h->fbuf, h->fbuf_size);
+  }
+  else
+  #endif
+  {
+    mem_free(h->mem, h->fbuf);
+  }
+  h->fbuf = NULL;
+  h->fbuf_size = 0;
+  h->fbuf_mmapped = false;
 }
 
-static bool history_read_entry( history_t* h, FILE* f, stringbuf_t* sbuf ) {
-  sbuf_clear(sbuf);
-  while( !feof(f)) {
-    int c = fgetc(f);
-    if (c == EOF || c == '\n') break;
-    if (c == '\\') {
-      c = fgetc(f);
-      if (c == 'n')       { sbuf_append(sbuf,"\n"); }
-      else if (c == 'r')  { /* ignore */ }  // sbuf_append(sbuf,"\r");
-      else if (c == 't')  { sbuf_append(sbuf,"\t"); }
-      else if (c == '\\') { sbuf_append(sbuf,"\\"); }
-      else if (c == 'x') {
-        int c1 = fgetc(f);         
-        int c2 = fgetc(f);
-        if (ic_isxdigit(c1) && ic_isxdigit(c2)) {
-          char chr = from_xdigit(c1)*16 + from_xdigit(c2);
-          sbuf_append_char(sbuf,chr);
-        }
-        else return false;
-      }
-      else return false;
+// load (or map) the entire history file into `h->fbuf`
+static bool history_load_file(history_t* h) {
+  history_unload_file(h);
+  #if !defined(_WIN32)
+  int fd = open(h->fname, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void* base = mmap(NULL, to_size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base != MAP_FAILED) {
+      h->fbuf = (char*)base;
+      h->fbuf_size = to_size_t(st.st_size);
+      h->fbuf_mmapped = true;
+    }
+  }
+  close(fd);
+  if (h->fbuf != NULL) return true;
+  #endif
+  // fallback: read the file contents on the heap
+  FILE* f = fopen(h->fname, "rb");
+  if (f == NULL) return false;
+  fseek(f, 0, SEEK_END);
+  long fsize = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (fsize > 0) {
+    char* buf = mem_malloc_tp_n(h->mem, char, fsize);
+    if (buf != NULL && fread(buf, 1, to_size_t(fsize), f) == to_size_t(fsize)) {
+      h->fbuf = buf;
+      h->fbuf_size = to_size_t(fsize);
+    }
+    else {
+      mem_free(h->mem, buf);
     }
-    else sbuf_append_char(sbuf,(char)c);
   }
-  if (sbuf_len(sbuf)==0 || sbuf_string(sbuf)[0] == '#') return true;
-  return history_push(h, sbuf_string(sbuf));
+  fclose(f);
+  return (h->fbuf != NULL);
+}
+
+static bool history_line_is_entry( const char* s, ssize_t len ) {
+  return (len > 0 && s[0] != '#');  // skip empty lines and comments
+}
+
+ic_private void history_load( history_t* h ) {
+  if (h->fname == NULL || h->len <= 0) return;
+  const int lockfd = history_file_lock(h, false);  // shared: a sibling may be compacting
+  const bool loaded = history_load_file(h);
+  history_file_unlock(lockfd);
+  h->fsize = (loaded ? to_ssize_t(h->fbuf_size) : 0);
+  if (!loaded) return;
+  history_index_invalidate(h);  // entries are filled in directly below
+  history_dedup_invalidate(h);
+  // scan backward over the lines so we only index the last `h->len` entries
+  // without touching (or decoding) the rest of a potentially large file
+  const char* s = h->fbuf;
+  ssize_t end = to_ssize_t(h->fbuf_size);
+  ssize_t first = h->len; // fill from the back of `elems`
+  while (end > 0 && first > 0) {
+    ssize_t start = end;
+    while (start > 0 && s[start-1] != '\n') { start--; }
+    ssize_t line_len = end - start;
+    if (line_len > 0 && s[start + line_len - 1] == '\r') { line_len--; }
+    if (history_line_is_entry(s + start, line_len)) {
+      first--;
+      h->elems[first].text    = NULL;     // decode lazily
+      h->elems[first].raw     = s + start;
+      h->elems[first].raw_len = line_len;
+      h->elems[first].saved   = true;
+    }
+    end = start - 1;  // skip the newline
+  }
+  // move the indexed entries to the start of `elems` (in file order)
+  h->count = h->len - first;
+  if (first > 0 && h->count > 0) {
+    ic_memmove(h->elems, h->elems + first, h->count * ssizeof(hentry_t));
+  }
+  debug_msg("history: loaded %zd entries from %s\n", h->count, h->fname);
 }
 
 static bool history_write_entry( const char* entry, FILE* f, stringbuf_t* sbuf ) {
@@ -222,14 +623,14 @@ static bool history_write_entry( const char* entry, FILE* f, stringbuf_t* sbuf )
     else if (c < ' ' || c > '~' || c == '#') {
       char c1 = to_xdigit( (uint8_t)c / 16 );
       char c2 = to_xdigit( (uint8_t)c % 16 );
-      sbuf_append(sbuf,"\\x"); 
-      sbuf_append_char(sbuf,c1); 
-      sbuf_append_char(sbuf,c2);            
+      sbuf_append(sbuf,"\\x");
+      sbuf_append_char(sbuf,c1);
+      sbuf_append_char(sbuf,c2);
     }
     else sbuf_append_char(sbuf,c);
   }
   //debug_msg("history: write buf: %s\n", sbuf_string(sbuf));
-  
+
   if (sbuf_len(sbuf) > 0) {
     sbuf_append(sbuf,"\n");
     fputs(sbuf_string(sbuf),f);
@@ -237,33 +638,148 @@ static bool history_write_entry( const char* entry, FILE* f, stringbuf_t* sbuf )
   return true;
 }
 
-ic_private void history_load( history_t* h ) {
-  if (h->fname == NULL) return;
-  FILE* f = fopen(h->fname, "r");
+// insert an owned `text` as an already persisted entry, placed before our
+// own unsaved entries so local additions stay the most recent
+static void history_insert_saved( history_t* h, char* text ) {
+  if (!h->allow_duplicates) {
+    history_dedup_ensure(h);
+    if (h->dedup_valid) {
+      ssize_t dup;
+      while ((dup = history_dedup_lookup(h, text)) >= 0) {
+        history_delete_at(h, dup);
+      }
+    }
+    else {
+      for (ssize_t i = h->count-1; i >= 0; i--) {
+        if (strcmp(history_entry_text(h,i), text) == 0) {
+          history_delete_at(h, i);
+        }
+      }
+    }
+  }
+  if (h->count == h->len) {
+    history_delete_at(h, 0);  // delete oldest entry
+  }
+  ssize_t at = h->count;
+  while (at > 0 && !h->elems[at-1].saved) { at--; }
+  if (at < h->count) {
+    ic_memmove(h->elems + at + 1, h->elems + at, (h->count - at)*ssizeof(hentry_t));
+  }
+  h->elems[at].text    = text;
+  h->elems[at].raw     = NULL;
+  h->elems[at].raw_len = 0;
+  h->elems[at].saved   = true;
+  h->count++;
+  history_index_invalidate(h);  // entry indices shifted
+  history_dedup_invalidate(h);
+}
+
+// Merge entries that sibling processes appended to the history file since
+// we last read or wrote it (the region past `h->fsize`). Must be called
+// with the history file lock held.
+static void history_merge_appended( history_t* h ) {
+  if (h->fname == NULL || h->len <= 0) return;
+  FILE* f = fopen(h->fname, "rb");
   if (f == NULL) return;
-  stringbuf_t* sbuf = sbuf_new(h->mem);
-  if (sbuf != NULL) {
-    while (!feof(f)) {
-      if (!history_read_entry(h,f,sbuf)) break; // error
+  fseek(f, 0, SEEK_END);
+  const ssize_t fend = (ssize_t)ftell(f);
+  if (fend <= h->fsize) {
+    if (fend < h->fsize) { h->fsize = fend; }  // a sibling compacted the file
+    fclose(f);
+    return;
+  }
+  const ssize_t n = fend - h->fsize;
+  char* buf = mem_malloc_tp_n(h->mem, char, n);
+  if (buf != NULL && fseek(f, (long)h->fsize, SEEK_SET) == 0 &&
+      fread(buf, 1, to_size_t(n), f) == to_size_t(n))
+  {
+    ssize_t pos = 0;
+    while (pos < n) {
+      ssize_t eol = pos;
+      while (eol < n && buf[eol] != '\n') { eol++; }
+      ssize_t line_len = eol - pos;
+      if (line_len > 0 && buf[pos + line_len - 1] == '\r') { line_len--; }
+      if (history_line_is_entry(buf + pos, line_len)) {
+        char* text = history_decode_entry(h, buf + pos, line_len);
+        if (text != NULL) { history_insert_saved(h, text); }
+      }
+      pos = eol + 1;
     }
-    sbuf_free(sbuf);
+    h->fsize = fend;
   }
+  mem_free(h->mem, buf);
   fclose(f);
 }
 
-ic_private void history_save( const history_t* h ) {
+// name of the compaction temp file: "<fname>.tmp" (caller frees)
+static char* history_tmp_name( history_t* h ) {
+  const ssize_t n = ic_strlen(h->fname);
+  char* s = mem_malloc_tp_n(h->mem, char, n + 5);
+  if (s == NULL) return NULL;
+  strcpy(s, h->fname);
+  strcpy(s + n, ".tmp");
+  return s;
+}
+
+#define IC_HISTORY_COMPACT_SIZE  (64*1024)   // compact (fully rewrite) the history file past this size
+
+ic_private void history_save( history_t* h ) {
   if (h->fname == NULL) return;
-  FILE* f = fopen(h->fname, "w");
-  if (f == NULL) return;
+  const int lockfd = history_file_lock(h, true);
+  // first reconcile with entries appended by sibling processes
+  history_merge_appended(h);
+  // append new entries if possible; rewrite the whole file when entries were
+  // removed (duplicates, ic_history_clear, etc.) or to compact an oversized file
+  bool rewrite = h->needs_rewrite;
+  if (!rewrite) {
+    struct stat st;
+    if (stat(h->fname, &st) == 0 && st.st_size > IC_HISTORY_COMPACT_SIZE) { rewrite = true; }
+  }
+  char* tmpname = NULL;
+  FILE* f = NULL;
+  if (rewrite) {
+    #if !defined(_WIN32)
+    // compact into a fresh file and rename it over the old one so the
+    // mapped history file of a sibling process stays readable
+    tmpname = history_tmp_name(h);
+    if (tmpname != NULL) {
+      f = fopen(tmpname, "w");
+      if (f == NULL) { mem_free(h->mem, tmpname); tmpname = NULL; }
+    }
+    #endif
+    if (f == NULL) {
+      // decode all entries up front: their raw spans may point into the
+      // mapped file we are about to truncate
+      for (ssize_t i = 0; i < h->count; i++) { history_entry_text(h,i); }
+      f = fopen(h->fname, "w");
+    }
+  }
+  else {
+    f = fopen(h->fname, "a");
+  }
+  if (f == NULL) {
+    history_file_unlock(lockfd);
+    return;
+  }
   #ifndef _WIN32
-  chmod(h->fname,S_IRUSR|S_IWUSR);
+  chmod((tmpname != NULL ? tmpname : h->fname), S_IRUSR|S_IWUSR);
   #endif
   stringbuf_t* sbuf = sbuf_new(h->mem);
   if (sbuf != NULL) {
-    for( int i = 0; i < h->count; i++ )  {
-      if (!history_write_entry(h->elems[i],f,sbuf)) break;  // error
+    for( ssize_t i = 0; i < h->count; i++ )  {
+      if (!rewrite && h->elems[i].saved) continue;
+      if (!history_write_entry(history_entry_text(h,i),f,sbuf)) break;  // error
+      h->elems[i].saved = true;
     }
     sbuf_free(sbuf);
   }
-  fclose(f);  
+  fflush(f);
+  h->fsize = (ssize_t)ftell(f);
+  fclose(f);
+  if (tmpname != NULL) {
+    rename(tmpname, h->fname);
+    mem_free(h->mem, tmpname);
+  }
+  if (rewrite) { h->needs_rewrite = false; }
+  history_file_unlock(lockfd);
 }
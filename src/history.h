@@ -25,14 +25,14 @@ ic_private ssize_t  history_count(const history_t* h);
 
 ic_private void     history_load_from(history_t* h, const char* fname, long max_entries);
 ic_private void     history_load( history_t* h );
-ic_private void     history_save( const history_t* h );
+ic_private void     history_save( history_t* h );
 
 ic_private bool     history_push( history_t* h, const char* entry );
 ic_private bool     history_update( history_t* h, const char* entry );
-ic_private const char* history_get( const history_t* h, ssize_t n );
+ic_private const char* history_get( history_t* h, ssize_t n );
 ic_private void     history_remove_last(history_t* h);
 
-ic_private bool     history_search( const history_t* h, ssize_t from, const char* search, bool backward, ssize_t* hidx, ssize_t* hpos);
+ic_private bool     history_search( history_t* h, ssize_t from, const char* search, bool backward, ssize_t* hidx, ssize_t* hpos);
 
 
 #endif // IC_HISTORY_H
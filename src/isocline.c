@@ -55,9 +55,8 @@
 
 static char*  ic_getline( alloc_t* mem );
 
-ic_public char* ic_readline(const char* prompt_text) 
+static char* ic_readline_with(ic_env_t* env, const char* prompt_text)
 {
-  ic_env_t* env = ic_get_env();
   if (env == NULL) return NULL;
   if (!env->noedit) {
     // terminal editing enabled
@@ -79,6 +78,74 @@ ic_public char* ic_readline(const char* prompt_text)
   }
 }
 
+ic_public char* ic_readline(const char* prompt_text)
+{
+  return ic_readline_with(ic_get_env(), prompt_text);
+}
+
+
+//-------------------------------------------------------------
+// Explicit environments: each handle owns its own terminal,
+// tty, history, and completions so sessions on different
+// pty's can run concurrently without sharing state.
+//-------------------------------------------------------------
+
+static ic_env_t* ic_env_create( ic_malloc_fun_t* _malloc, ic_realloc_fun_t* _realloc, ic_free_fun_t* _free, int fd_in, int fd_out );
+
+ic_public ic_env_t* ic_env_new(int fd_in, int fd_out) {
+  return ic_env_create(NULL, NULL, NULL, fd_in, fd_out);
+}
+
+ic_public char* ic_env_readline(ic_env_t* env, const char* prompt_text) {
+  return ic_readline_with(env, prompt_text);
+}
+
+ic_public void ic_env_set_history(ic_env_t* env, const char* fname, long max_entries) {
+  if (env == NULL) return;
+  history_load_from(env->history, fname, max_entries);
+}
+
+ic_public void ic_env_set_default_completer(ic_env_t* env, ic_completer_fun_t* completer, void* arg) {
+  if (env == NULL) return;
+  completions_set_completer(env->completions, completer, arg);
+}
+
+ic_public void ic_env_set_default_highlighter(ic_env_t* env, ic_highlight_fun_t* highlighter, void* arg) {
+  if (env == NULL) return;
+  env->highlighter = highlighter;
+  env->highlighter_arg = arg;
+}
+
+
+//-------------------------------------------------------------
+// Non-blocking readline for event loops
+//-------------------------------------------------------------
+
+ic_public bool ic_readline_start(const char* prompt_text) {
+  ic_env_t* env = ic_get_env();
+  if (env == NULL || env->noedit || env->tty == NULL || env->term == NULL) return false;
+  return ic_editline_start(env, prompt_text);   // in editline.c
+}
+
+ic_public bool ic_readline_poll(char** line) {
+  ic_env_t* env = ic_get_env();
+  if (env == NULL) return false;
+  return ic_editline_poll(env, line);
+}
+
+ic_public long ic_readline_feed(const char* input, long len) {
+  ic_env_t* env = ic_get_env();
+  if (env == NULL || env->tty == NULL || input == NULL) return 0;
+  if (len < 0) { len = (long)ic_strlen(input); }
+  return (long)tty_feed(env->tty, input, (ssize_t)len);
+}
+
+ic_public int ic_readline_fd(void) {
+  ic_env_t* env = ic_get_env();
+  if (env == NULL || env->tty == NULL) return -1;
+  return tty_get_fd(env->tty);
+}
+
 
 //-------------------------------------------------------------
 // Read a line from the stdin stream if there is no editing 
@@ -120,6 +187,11 @@ ic_public void ic_vprintf(const char* fmt, va_list args) {
   bbcode_vprintf(env->bbcode, fmt, args);
 }
 
+ic_public bool ic_enable_pager( bool enable ) {
+  ic_env_t* env = ic_get_env(); if (env==NULL || env->bbcode==NULL) return false;
+  return bbcode_enable_pager(env->bbcode, enable);
+}
+
 ic_public void ic_print(const char* s) {
   ic_env_t* env = ic_get_env(); if (env==NULL || env->bbcode==NULL) return;
   bbcode_print(env->bbcode, s);
@@ -130,6 +202,20 @@ ic_public void ic_println(const char* s) {
   bbcode_println(env->bbcode, s);
 }
 
+ic_public ic_bbcode_template_t* ic_bbcode_template_new(const char* s) {
+  ic_env_t* env = ic_get_env(); if (env==NULL || env->bbcode==NULL) return NULL;
+  return (ic_bbcode_template_t*)bbcode_template_new(env->bbcode, s);
+}
+
+ic_public void ic_bbcode_template_free(ic_bbcode_template_t* tpl) {
+  bbcode_template_free((bbtemplate_t*)tpl);
+}
+
+ic_public void ic_print_template(const ic_bbcode_template_t* tpl, const char** args, size_t arg_count) {
+  ic_env_t* env = ic_get_env(); if (env==NULL || env->bbcode==NULL) return;
+  bbcode_template_print(env->bbcode, (const bbtemplate_t*)tpl, args, (ssize_t)arg_count);
+}
+
 void ic_style_def(const char* name, const char* fmt) {
   ic_env_t* env = ic_get_env(); if (env==NULL || env->bbcode==NULL) return;
   bbcode_style_def(env->bbcode, name, fmt);
@@ -229,6 +315,11 @@ ic_public bool ic_enable_auto_tab( bool enable ) {
   return prev;
 }
 
+ic_public bool ic_enable_fuzzy_completion( bool enable ) {
+  ic_env_t* env = ic_get_env(); if (env==NULL) return false;
+  return completions_enable_fuzzy(env->completions, enable);
+}
+
 ic_public bool ic_enable_completion_preview( bool enable ) {
   ic_env_t* env = ic_get_env(); if (env==NULL) return false;
   bool prev = env->complete_nopreview;
@@ -271,6 +362,13 @@ ic_public bool ic_enable_highlight(bool enable) {
   return !prev;
 }
 
+ic_public bool ic_enable_incremental_highlight(bool enable) {
+  ic_env_t* env = ic_get_env(); if (env==NULL) return false;
+  bool prev = env->incremental_highlight;
+  env->incremental_highlight = enable;
+  return prev;
+}
+
 ic_public bool ic_enable_inline_help(bool enable) {
   ic_env_t* env = ic_get_env(); if (env==NULL) return false;
   bool prev = env->no_help;
@@ -352,6 +450,27 @@ ic_public const char* ic_strdup( const char* s ) {
   return p;
 }
 
+//-------------------------------------------------------------
+// Statistics
+//-------------------------------------------------------------
+
+ic_public bool ic_get_stats( ic_stats_t* stats ) {
+  if (stats == NULL) return false;
+  #if defined(IC_STATS)
+  *stats = ic_stats;
+  return true;
+  #else
+  memset(stats, 0, sizeof(*stats));
+  return false;
+  #endif
+}
+
+ic_public void ic_reset_stats(void) {
+  #if defined(IC_STATS)
+  memset(&ic_stats, 0, sizeof(ic_stats));
+  #endif
+}
+
 //-------------------------------------------------------------
 // Terminal
 //-------------------------------------------------------------
@@ -484,14 +603,23 @@ ic_public char* ic_readline_ex(const char* prompt_text,
 
 static void ic_atexit(void);
 
-static void ic_env_free(ic_env_t* env) {
+ic_public void ic_env_free(ic_env_t* env) {
   if (env == NULL) return;
   history_save(env->history);
   history_free(env->history);
   completions_free(env->completions);
+  dircache_free(env->dircache);
   bbcode_free(env->bbcode);
   term_free(env->term);
   tty_free(env->tty);
+  sbuf_free(env->edit_input);
+  sbuf_free(env->edit_extra);
+  sbuf_free(env->edit_hint);
+  sbuf_free(env->edit_hint_help);
+  attrbuf_free(env->edit_attrs);
+  attrbuf_free(env->edit_attrs_extra);
+  attrbuf_free(env->edit_attrs_hl);
+  arena_free(env->edit_arena);
   mem_free(env->mem, env->cprompt_marker);
   mem_free(env->mem,env->prompt_marker);
   mem_free(env->mem, env->match_braces);
@@ -507,7 +635,7 @@ static void ic_env_free(ic_env_t* env) {
 }
 
 
-static ic_env_t* ic_env_create( ic_malloc_fun_t* _malloc, ic_realloc_fun_t* _realloc, ic_free_fun_t* _free )  
+static ic_env_t* ic_env_create( ic_malloc_fun_t* _malloc, ic_realloc_fun_t* _realloc, ic_free_fun_t* _free, int fd_in, int fd_out )
 {
   if (_malloc == NULL)  _malloc = &malloc;
   if (_realloc == NULL) _realloc = &realloc;
@@ -518,6 +646,7 @@ static ic_env_t* ic_env_create( ic_malloc_fun_t* _malloc, ic_realloc_fun_t* _rea
   mem->malloc = _malloc;
   mem->realloc = _realloc;
   mem->free = _free;
+  mem->arena = NULL;
   ic_env_t* env = mem_zalloc_tp(mem, ic_env_t);
   if (env==NULL) {
     mem->free(mem);
@@ -526,8 +655,8 @@ static ic_env_t* ic_env_create( ic_malloc_fun_t* _malloc, ic_realloc_fun_t* _rea
   env->mem = mem;
 
   // Initialize
-  env->tty         = tty_new(env->mem, -1);  // can return NULL
-  env->term        = term_new(env->mem, env->tty, false, false, -1 );  
+  env->tty         = tty_new(env->mem, fd_in);  // can return NULL
+  env->term        = term_new(env->mem, env->tty, false, false, fd_out );
   env->history     = history_new(env->mem);
   env->completions = completions_new(env->mem);
   env->bbcode      = bbcode_new(env->mem, env->term);
@@ -572,7 +701,7 @@ static void ic_atexit(void) {
 
 ic_private ic_env_t* ic_get_env(void) {  
   if (rpenv==NULL) {
-    rpenv = ic_env_create( NULL, NULL, NULL );
+    rpenv = ic_env_create( NULL, NULL, NULL, -1, -1 );
     if (rpenv != NULL) { atexit( &ic_atexit ); }
   }
   return rpenv;
@@ -582,10 +711,10 @@ ic_public void ic_init_custom_malloc( ic_malloc_fun_t* _malloc, ic_realloc_fun_t
   assert(rpenv == NULL);
   if (rpenv != NULL) {
     ic_env_free(rpenv);    
-    rpenv = ic_env_create( _malloc, _realloc, _free ); 
+    rpenv = ic_env_create( _malloc, _realloc, _free, -1, -1 ); 
   }
   else {
-    rpenv = ic_env_create( _malloc, _realloc, _free ); 
+    rpenv = ic_env_create( _malloc, _realloc, _free, -1, -1 ); 
     if (rpenv != NULL) {
       atexit( &ic_atexit );
     }
@@ -33,11 +33,43 @@
 // In place growable utf-8 strings
 //-------------------------------------------------------------
 
+// one terminal row in the cached row layout
+typedef struct rowinfo_s {
+  ssize_t start;      // byte offset of the row start
+  ssize_t len;        // byte length of the row (excluding a terminating newline)
+  bool    is_wrap;    // row ends in a soft wrap (instead of a newline or the end)
+} rowinfo_t;
+
 struct stringbuf_s {
   char*     buf;
   ssize_t   buflen;
-  ssize_t   count;  
+  ssize_t   count;    // logical length (excluding the gap)
   alloc_t*  mem;
+  // gap buffer mode (opt-in, used for the editor input buffer):
+  // the buffer keeps a gap of `gap_len` free bytes at logical position
+  // `gap_pos` so repeated inserts/deletes around one position (the cursor)
+  // only move bytes proportional to the cursor movement instead of the
+  // whole tail. Readers get a lazily refreshed contiguous `shadow` copy
+  // (see `sbuf_cstr`) so the gap survives a refresh and stays at the cursor.
+  ssize_t   gap_pos;
+  ssize_t   gap_len;
+  bool      gap_mode;
+  char*     shadow;         // contiguous shadow of the logical string (gap mode only)
+  ssize_t   shadow_buflen;  // allocated shadow size
+  ssize_t   shadow_valid;   // leading logical bytes of `shadow` that are up-to-date
+  // cached row layout: the (wrapped) terminal rows for the current content
+  // and width parameters. Edits only mark a low-water position so the next
+  // use recomputes from the row containing the edit instead of re-walking
+  // the entire buffer for every cursor movement and refresh.
+  rowinfo_t* rows;
+  ssize_t    rows_count;
+  ssize_t    rows_capacity;
+  ssize_t    layout_termw;
+  ssize_t    layout_promptw;
+  ssize_t    layout_cpromptw;
+  ssize_t    layout_dirty;   // lowest edited byte position (-1 if the layout is up-to-date)
+  bool       layout_valid;
+  ssize_t    edit_dirty;     // lowest edited byte position since `sbuf_edit_reset` (-1 if unedited)
 };
 
 
@@ -95,16 +127,50 @@ static ssize_t char_column_width( const char* s, ssize_t n ) {
   }
 }
 
-static ssize_t str_column_width_n( const char* s, ssize_t len ) {
+// Length of the run of printable ASCII characters (0x20-0x7E) starting at
+// `s+pos`. Such characters are one byte and one column each so the width
+// scanning loops can process them in bulk instead of decoding one codepoint
+// at a time. Scans 8 bytes at a time (SWAR): a chunk passes when no byte has
+// its high bit set, is below 0x20 (controls and ESC), or equals 0x7F (DEL).
+static ssize_t str_ascii_run( const char* s, ssize_t len, ssize_t pos ) {
+  const uint64_t himask = UINT64_C(0x8080808080808080);
+  const uint64_t lomask = UINT64_C(0x0101010101010101);
+  ssize_t i = pos;
+  while (i + 8 <= len) {
+    uint64_t v;
+    memcpy(&v, s + i, 8);  // unaligned load
+    const uint64_t x = v ^ (UINT64_C(0x7F)*lomask);               // 0x7F bytes become zero
+    const uint64_t bad = (v & himask)                             // high bit set (utf8)
+                       | ((v - (UINT64_C(0x20)*lomask)) & ~v & himask)  // below 0x20 (control or ESC)
+                       | ((x - lomask) & ~x & himask);            // equal to 0x7F (DEL)
+    if (bad != 0) break;
+    i += 8;
+  }
+  while (i < len) {
+    const uint8_t b = (uint8_t)s[i];
+    if (b < 0x20 || b >= 0x7F) break;
+    i++;
+  }
+  return (i - pos);
+}
+
+ic_private ssize_t str_column_width_n( const char* s, ssize_t len ) {
   if (s == NULL || len <= 0) return 0;
   ssize_t pos = 0;
   ssize_t cwidth = 0;
   ssize_t cw;
   ssize_t ofs;
-  while (s[pos] != 0 && (ofs = str_next_ofs(s, len, pos, &cw)) > 0) {
+  while (pos < len) {
+    const ssize_t run = str_ascii_run(s, len, pos);  // one column per byte
+    if (run > 0) {
+      cwidth += run;
+      pos += run;
+      continue;
+    }
+    if (s[pos] == 0 || (ofs = str_next_ofs(s, len, pos, &cw)) <= 0) break;
     cwidth += cw;
     pos += ofs;
-  }  
+  }
   return cwidth;
 }
 
@@ -545,12 +611,12 @@ static ssize_t str_get_pos_at_rc(const char* s, ssize_t len, ssize_t termw, ssiz
 //-------------------------------------------------------------
 // String buffer
 //-------------------------------------------------------------
-static bool sbuf_ensure_extra(stringbuf_t* s, ssize_t extra) 
+static bool sbuf_ensure_extra(stringbuf_t* s, ssize_t extra)
 {
-  if (s->buflen >= s->count + extra) return true;   
+  if (s->buflen >= s->count + s->gap_len + extra) return true;
   // reallocate; pick good initial size and multiples to increase reuse on allocation
   ssize_t newlen = (s->buflen <= 0 ? 120 : (s->buflen > 1000 ? s->buflen + 1000 : 2*s->buflen));
-  if (newlen < s->count + extra) newlen = s->count + extra;
+  if (newlen < s->count + s->gap_len + extra) newlen = s->count + s->gap_len + extra;
   if (s->buflen > 0) {
     debug_msg("stringbuf: reallocate: old %zd, new %zd\n", s->buflen, newlen);
   }
@@ -561,8 +627,208 @@ static bool sbuf_ensure_extra(stringbuf_t* s, ssize_t extra)
   }
   s->buf = newbuf;
   s->buflen = newlen;
-  s->buf[s->count] = s->buf[s->buflen] = 0;
-  assert(s->buflen >= s->count + extra);
+  s->buf[s->buflen] = 0;
+  if (s->gap_len == 0) { s->buf[s->count] = 0; }
+  assert(s->buflen >= s->count + s->gap_len + extra);
+  return true;
+}
+
+//-------------------------------------------------------------
+// Gap buffer mode
+//-------------------------------------------------------------
+
+#define IC_GAP_EXTRA  (256)   // extra gap bytes so adjacent edits stay in the gap
+
+// make the logical bytes contiguous again (and zero terminated)
+static void sbuf_gap_close(stringbuf_t* sbuf) {
+  if (sbuf->gap_len <= 0) return;
+  ic_memmove(sbuf->buf + sbuf->gap_pos, sbuf->buf + sbuf->gap_pos + sbuf->gap_len, sbuf->count - sbuf->gap_pos);
+  sbuf->gap_len = 0;
+  sbuf->gap_pos = 0;
+  sbuf->buf[sbuf->count] = 0;
+}
+
+// move the gap to logical position `pos`; moves only |gap_pos - pos| bytes
+static void sbuf_gap_move(stringbuf_t* sbuf, ssize_t pos) {
+  assert(pos >= 0 && pos <= sbuf->count);
+  if (sbuf->gap_len <= 0) {
+    sbuf->gap_pos = pos;
+    return;
+  }
+  if (pos < sbuf->gap_pos) {
+    ic_memmove(sbuf->buf + pos + sbuf->gap_len, sbuf->buf + pos, sbuf->gap_pos - pos);
+  }
+  else if (pos > sbuf->gap_pos) {
+    ic_memmove(sbuf->buf + sbuf->gap_pos, sbuf->buf + sbuf->gap_pos + sbuf->gap_len, pos - sbuf->gap_pos);
+  }
+  sbuf->gap_pos = pos;
+}
+
+// contiguous read-only view of the logical string (zero terminated).
+// In gap mode this is a lazily refreshed shadow copy so a read never closes
+// the gap: closing would force the next insert at the cursor to move the
+// whole tail right again -- two tail moves per keystroke once a refresh
+// reads the string in between. Only the bytes from the lowest edit since
+// the previous view are recopied (see `sbuf_layout_edited`).
+static const char* sbuf_cstr(stringbuf_t* sbuf) {
+  if (sbuf->buf == NULL) return "";
+  if (sbuf->gap_len <= 0) {
+    sbuf->buf[sbuf->count] = 0;
+    return sbuf->buf;
+  }
+  if (sbuf->shadow_buflen < sbuf->count + 1) {
+    char* newshadow = mem_realloc_tp(sbuf->mem, char, sbuf->shadow, sbuf->buflen + 1);
+    if (newshadow == NULL) {
+      sbuf_gap_close(sbuf);  // no memory: degrade to closing the gap
+      return sbuf->buf;
+    }
+    sbuf->shadow = newshadow;
+    sbuf->shadow_buflen = sbuf->buflen + 1;
+  }
+  // refresh only from the lowest edited position on
+  ssize_t from = (sbuf->shadow_valid < 0 ? 0 : sbuf->shadow_valid);
+  if (from < sbuf->gap_pos) {
+    ic_memcpy(sbuf->shadow + from, sbuf->buf + from, sbuf->gap_pos - from);
+    from = sbuf->gap_pos;
+  }
+  if (from < sbuf->count) {
+    ic_memcpy(sbuf->shadow + from, sbuf->buf + from + sbuf->gap_len, sbuf->count - from);
+  }
+  sbuf->shadow[sbuf->count] = 0;
+  sbuf->shadow_valid = sbuf->count;
+  return sbuf->shadow;
+}
+
+// opt into (or out of) gap buffer storage
+ic_private void sbuf_set_gap_buffer(stringbuf_t* sbuf, bool enable) {
+  if (sbuf == NULL) return;
+  if (!enable) { sbuf_gap_close(sbuf); }
+  sbuf->gap_mode = enable;
+}
+
+//-------------------------------------------------------------
+// Cached row layout
+//-------------------------------------------------------------
+
+// an edit at `pos` can only affect rows from the row containing `pos` onward
+static void sbuf_layout_edited(stringbuf_t* sbuf, ssize_t pos) {
+  if (pos < 0) pos = 0;
+  if (sbuf->shadow_valid > pos) {
+    sbuf->shadow_valid = pos;   // the contiguous shadow is stale from the edit on
+  }
+  if (sbuf->edit_dirty < 0 || pos < sbuf->edit_dirty) {
+    sbuf->edit_dirty = pos;
+  }
+  if (!sbuf->layout_valid) return;
+  if (sbuf->layout_dirty < 0 || pos < sbuf->layout_dirty) {
+    sbuf->layout_dirty = pos;
+  }
+}
+
+// lowest byte position edited since the last `sbuf_edit_reset` (-1 if unedited);
+// used for incremental highlighting.
+ic_private ssize_t sbuf_edited_at(const stringbuf_t* sbuf) {
+  return (sbuf == NULL ? -1 : sbuf->edit_dirty);
+}
+
+ic_private void sbuf_edit_reset(stringbuf_t* sbuf) {
+  if (sbuf != NULL) { sbuf->edit_dirty = -1; }
+}
+
+static bool sbuf_layout_push(stringbuf_t* sbuf, ssize_t row, ssize_t start, ssize_t len, bool is_wrap) {
+  if (row >= sbuf->rows_capacity) {
+    const ssize_t newcap = (sbuf->rows_capacity <= 0 ? 16 : 2*sbuf->rows_capacity);
+    rowinfo_t* newrows = mem_realloc_tp(sbuf->mem, rowinfo_t, sbuf->rows, newcap);
+    if (newrows == NULL) return false;
+    sbuf->rows = newrows;
+    sbuf->rows_capacity = newcap;
+  }
+  sbuf->rows[row].start = start;
+  sbuf->rows[row].len = len;
+  sbuf->rows[row].is_wrap = is_wrap;
+  return true;
+}
+
+// binary search for the row containing `pos`; on an exact soft-wrap
+// boundary the later row wins (the cursor shows at the wrapped row start).
+static ssize_t sbuf_layout_find_row(const stringbuf_t* sbuf, ssize_t pos) {
+  ssize_t lo = 0;
+  ssize_t hi = sbuf->rows_count - 1;
+  while (lo < hi) {
+    const ssize_t mid = lo + (hi - lo + 1)/2;
+    if (sbuf->rows[mid].start <= pos) { lo = mid; }
+                                 else { hi = mid - 1; }
+  }
+  return lo;
+}
+
+// (re)compute the row layout; after an edit only the rows from the edit
+// position onward are re-walked, rows before it are reused as-is.
+static bool sbuf_layout_ensure(stringbuf_t* sbuf, ssize_t termw, ssize_t promptw, ssize_t cpromptw) {
+  const bool same_widths = (sbuf->layout_termw == termw && sbuf->layout_promptw == promptw &&
+                            sbuf->layout_cpromptw == cpromptw);
+  if (sbuf->layout_valid && same_widths && sbuf->layout_dirty < 0) return true;
+  ssize_t rcount = 0;
+  ssize_t rstart = 0;
+  if (sbuf->layout_valid && same_widths && sbuf->layout_dirty > 0 && sbuf->rows_count > 0) {
+    // restart from the row containing the character just before the edit
+    // (an edit at a row start can still change the previous row's wrap point)
+    const ssize_t row = sbuf_layout_find_row(sbuf, sbuf->layout_dirty - 1);
+    rcount = row;
+    rstart = sbuf->rows[row].start;
+  }
+  const char* s = sbuf_cstr(sbuf);   // read across the gap; does not close it
+  const ssize_t len = sbuf->count;
+  ssize_t rcol = 0;
+  for (ssize_t i = rstart; i < len; ) {
+    // bulk-advance over printable ASCII up to the wrap point
+    const ssize_t run = str_ascii_run(s, len, i);
+    if (run > 0) {
+      ssize_t n = run;
+      if (termw != 0) {
+        // a char at column `rcol` fits when rcol + 1 + startw + 1 < termw
+        const ssize_t space = termw - (rcount == 0 ? promptw : cpromptw) - 2 - rcol;
+        if (n > space) n = space;
+      }
+      if (n > 0) {
+        i += n;
+        rcol += n;
+        continue;
+      }
+    }
+    ssize_t w;
+    const ssize_t next = str_next_ofs(s, len, i, &w);
+    if (next <= 0) {
+      debug_msg("stringbuf: layout: next<=0: len %zd, i %zd\n", len, i);
+      assert(false);
+      break;
+    }
+    const ssize_t startw = (rcount == 0 ? promptw : cpromptw);
+    const ssize_t termcol = rcol + w + startw + 1 /* for the cursor */;
+    if (termw != 0 && i != 0 && termcol >= termw) {
+      // wrap
+      if (!sbuf_layout_push(sbuf, rcount, rstart, i - rstart, true)) return false;
+      rcount++;
+      rstart = i;
+      rcol = 0;
+    }
+    if (s[i] == '\n') {
+      // newline
+      if (!sbuf_layout_push(sbuf, rcount, rstart, i - rstart, false)) return false;
+      rcount++;
+      rstart = i+1;
+      rcol = 0;
+    }
+    i += next;
+    rcol += w;
+  }
+  if (!sbuf_layout_push(sbuf, rcount, rstart, len - rstart, false)) return false;
+  sbuf->rows_count = rcount+1;
+  sbuf->layout_termw = termw;
+  sbuf->layout_promptw = promptw;
+  sbuf->layout_cpromptw = cpromptw;
+  sbuf->layout_dirty = -1;
+  sbuf->layout_valid = true;
   return true;
 }
 
@@ -571,13 +837,36 @@ static void sbuf_init( stringbuf_t* sbuf, alloc_t* mem ) {
   sbuf->buf = NULL;
   sbuf->buflen = 0;
   sbuf->count = 0;
+  sbuf->gap_pos = 0;
+  sbuf->gap_len = 0;
+  sbuf->gap_mode = false;
+  sbuf->shadow = NULL;
+  sbuf->shadow_buflen = 0;
+  sbuf->shadow_valid = 0;
+  sbuf->rows = NULL;
+  sbuf->rows_count = 0;
+  sbuf->rows_capacity = 0;
+  sbuf->layout_dirty = -1;
+  sbuf->layout_valid = false;
+  sbuf->edit_dirty = -1;
 }
 
 static void sbuf_done( stringbuf_t* sbuf ) {
   mem_free( sbuf->mem, sbuf->buf );
+  mem_free( sbuf->mem, sbuf->shadow );
+  mem_free( sbuf->mem, sbuf->rows );
   sbuf->buf = NULL;
   sbuf->buflen = 0;
   sbuf->count = 0;
+  sbuf->gap_pos = 0;
+  sbuf->gap_len = 0;
+  sbuf->shadow = NULL;
+  sbuf->shadow_buflen = 0;
+  sbuf->shadow_valid = 0;
+  sbuf->rows = NULL;
+  sbuf->rows_count = 0;
+  sbuf->rows_capacity = 0;
+  sbuf->layout_valid = false;
 }
 
 
@@ -599,6 +888,7 @@ ic_private char* sbuf_free_dup(stringbuf_t* sbuf) {
   if (sbuf == NULL) return NULL;
   char* s = NULL;
   if (sbuf->buf != NULL) {
+    sbuf_gap_close(sbuf);
     s = mem_realloc_tp(sbuf->mem, char, sbuf->buf, sbuf_len(sbuf)+1);
     if (s == NULL) { s = sbuf->buf; }
     sbuf->buf = 0;
@@ -612,8 +902,9 @@ ic_private char* sbuf_free_dup(stringbuf_t* sbuf) {
 ic_private const char* sbuf_string_at( stringbuf_t* sbuf, ssize_t pos ) {
   if (pos < 0 || sbuf->count < pos) return NULL;
   if (sbuf->buf == NULL) return "";
-  assert(sbuf->buf[sbuf->count] == 0);
-  return sbuf->buf + pos;
+  const char* s = sbuf_cstr(sbuf);
+  assert(s[sbuf->count] == 0);
+  return s + pos;
 }
 
 ic_private const char* sbuf_string( stringbuf_t* sbuf ) {
@@ -622,6 +913,9 @@ ic_private const char* sbuf_string( stringbuf_t* sbuf ) {
 
 ic_private char sbuf_char_at(stringbuf_t* sbuf, ssize_t pos) {
   if (sbuf->buf == NULL || pos < 0 || sbuf->count < pos) return 0;
+  if (sbuf->gap_len > 0 && pos >= sbuf->gap_pos) {
+    return (pos >= sbuf->count ? 0 : sbuf->buf[pos + sbuf->gap_len]);  // read over the gap
+  }
   return sbuf->buf[pos];
 }
 
@@ -639,6 +933,8 @@ ic_private ssize_t sbuf_len(const stringbuf_t* s) {
 }
 
 ic_private ssize_t sbuf_append_vprintf(stringbuf_t* sb, const char* fmt, va_list args) {
+  sbuf_gap_close(sb);
+  sbuf_layout_edited(sb, sb->count);
   const ssize_t min_needed = ic_strlen(fmt);
   if (!sbuf_ensure_extra(sb,min_needed + 16)) return sb->count;
   ssize_t avail = sb->buflen - sb->count;
@@ -670,7 +966,26 @@ ic_private ssize_t sbuf_appendf(stringbuf_t* sb, const char* fmt, ...) {
 ic_private ssize_t sbuf_insert_at_n(stringbuf_t* sbuf, const char* s, ssize_t n, ssize_t pos ) {
   if (pos < 0 || pos > sbuf->count || s == NULL) return pos;
   n = str_limit_to_length(s,n);
-  if (n <= 0 || !sbuf_ensure_extra(sbuf,n)) return pos;
+  if (n <= 0) return pos;
+  sbuf_layout_edited(sbuf, pos);
+  if (sbuf->gap_mode) {
+    // gap buffer: put the gap at the insertion point and fill it
+    sbuf_gap_move(sbuf, pos);
+    if (sbuf->gap_len < n) {
+      if (!sbuf_ensure_extra(sbuf, n - sbuf->gap_len + IC_GAP_EXTRA)) return pos;
+      // widen the gap with the newly ensured space (one tail move)
+      const ssize_t add = sbuf->buflen - (sbuf->count + sbuf->gap_len);
+      ic_memmove(sbuf->buf + sbuf->gap_pos + sbuf->gap_len + add,
+                 sbuf->buf + sbuf->gap_pos + sbuf->gap_len, sbuf->count - sbuf->gap_pos);
+      sbuf->gap_len += add;
+    }
+    ic_memcpy(sbuf->buf + sbuf->gap_pos, s, n);
+    sbuf->gap_pos += n;
+    sbuf->gap_len -= n;
+    sbuf->count += n;
+    return (pos + n);
+  }
+  if (!sbuf_ensure_extra(sbuf,n)) return pos;
   ic_memmove(sbuf->buf + pos + n, sbuf->buf + pos, sbuf->count - pos);
   ic_memcpy(sbuf->buf + pos, s, n);
   sbuf->count += n;
@@ -679,9 +994,11 @@ ic_private ssize_t sbuf_insert_at_n(stringbuf_t* sbuf, const char* s, ssize_t n,
 }
 
 ic_private stringbuf_t* sbuf_split_at( stringbuf_t* sb, ssize_t pos ) {
+  sbuf_gap_close(sb);
   stringbuf_t* res = sbuf_new(sb->mem);
   if (res==NULL || pos < 0) return NULL;
   if (pos < sb->count) {
+    sbuf_layout_edited(sb, pos);
     sbuf_append_n(res, sb->buf + pos, sb->count - pos);
     sb->count = pos;
   }
@@ -710,6 +1027,14 @@ ic_private ssize_t sbuf_insert_unicode_at(stringbuf_t* sbuf, unicode_t u, ssize_
 ic_private void sbuf_delete_at( stringbuf_t* sbuf, ssize_t pos, ssize_t count ) {
   if (pos < 0 || pos >= sbuf->count) return;
   if (pos + count > sbuf->count) count = sbuf->count - pos;
+  sbuf_layout_edited(sbuf, pos);
+  if (sbuf->gap_mode) {
+    // gap buffer: absorb the deleted bytes into the gap
+    sbuf_gap_move(sbuf, pos);
+    sbuf->gap_len += count;
+    sbuf->count -= count;
+    return;
+  }
   ic_memmove(sbuf->buf + pos, sbuf->buf + pos + count, sbuf->count - pos - count);
   sbuf->count -= count;
   sbuf->buf[sbuf->count] = 0;
@@ -750,11 +1075,11 @@ ic_private void sbuf_replace(stringbuf_t* sbuf, const char* s) {
 }
 
 ic_private ssize_t sbuf_next_ofs( stringbuf_t* sbuf, ssize_t pos, ssize_t* cwidth ) {
-  return str_next_ofs( sbuf->buf, sbuf->count, pos, cwidth);
+  return str_next_ofs( sbuf_cstr(sbuf), sbuf->count, pos, cwidth);
 }
 
 ic_private ssize_t sbuf_prev_ofs( stringbuf_t* sbuf, ssize_t pos, ssize_t* cwidth ) {
-  return str_prev_ofs( sbuf->buf, pos, cwidth);
+  return str_prev_ofs( sbuf_cstr(sbuf), pos, cwidth);
 }
 
 ic_private ssize_t sbuf_next( stringbuf_t* sbuf, ssize_t pos, ssize_t* cwidth) {
@@ -788,12 +1113,14 @@ ic_private void sbuf_delete_char_at( stringbuf_t* sbuf, ssize_t pos ) {
 }
 
 ic_private ssize_t sbuf_swap_char( stringbuf_t* sbuf, ssize_t pos ) {
+  sbuf_gap_close(sbuf);
   ssize_t next = sbuf_next_ofs(sbuf, pos, NULL);
-  if (next <= 0) return 0;  
+  if (next <= 0) return 0;
   ssize_t prev = sbuf_prev_ofs(sbuf, pos, NULL);
-  if (prev <= 0) return 0;  
+  if (prev <= 0) return 0;
   char buf[64];
   if (prev >= 63) return 0;
+  sbuf_layout_edited(sbuf, pos - prev);
   ic_memcpy(buf, sbuf->buf + pos - prev, prev );
   ic_memmove(sbuf->buf + pos - prev, sbuf->buf + pos, next);
   ic_memmove(sbuf->buf + pos - prev + next, buf, prev);
@@ -801,46 +1128,136 @@ ic_private ssize_t sbuf_swap_char( stringbuf_t* sbuf, ssize_t pos ) {
 }
 
 ic_private ssize_t sbuf_find_line_start( stringbuf_t* sbuf, ssize_t pos ) {
-  return str_find_line_start( sbuf->buf, sbuf->count, pos);
+  return str_find_line_start( sbuf_cstr(sbuf), sbuf->count, pos);
 }
 
 ic_private ssize_t sbuf_find_line_end( stringbuf_t* sbuf, ssize_t pos ) {
-  return str_find_line_end( sbuf->buf, sbuf->count, pos);
+  return str_find_line_end( sbuf_cstr(sbuf), sbuf->count, pos);
 }
 
 ic_private ssize_t sbuf_find_word_start( stringbuf_t* sbuf, ssize_t pos ) {
-  return str_find_word_start( sbuf->buf, sbuf->count, pos);
+  return str_find_word_start( sbuf_cstr(sbuf), sbuf->count, pos);
 }
 
 ic_private ssize_t sbuf_find_word_end( stringbuf_t* sbuf, ssize_t pos ) {
-  return str_find_word_end( sbuf->buf, sbuf->count, pos);
+  return str_find_word_end( sbuf_cstr(sbuf), sbuf->count, pos);
 }
 
 ic_private ssize_t sbuf_find_ws_word_start( stringbuf_t* sbuf, ssize_t pos ) {
-  return str_find_ws_word_start( sbuf->buf, sbuf->count, pos);
+  return str_find_ws_word_start( sbuf_cstr(sbuf), sbuf->count, pos);
 }
 
 ic_private ssize_t sbuf_find_ws_word_end( stringbuf_t* sbuf, ssize_t pos ) {
-  return str_find_ws_word_end( sbuf->buf, sbuf->count, pos);
+  return str_find_ws_word_end( sbuf_cstr(sbuf), sbuf->count, pos);
 }
 
 // find row/col position
 ic_private ssize_t sbuf_get_pos_at_rc( stringbuf_t* sbuf, ssize_t termw, ssize_t promptw, ssize_t cpromptw, ssize_t row, ssize_t col ) {
-  return str_get_pos_at_rc( sbuf->buf, sbuf->count, termw, promptw, cpromptw, row, col);
+  const char* s = sbuf_cstr(sbuf);
+  if (!sbuf_layout_ensure(sbuf, termw, promptw, cpromptw)) {
+    return str_get_pos_at_rc( s, sbuf->count, termw, promptw, cpromptw, row, col);
+  }
+  if (row < 0 || row >= sbuf->rows_count) return -1;
+  // scan only the target row for the column
+  const rowinfo_t* ri = &sbuf->rows[row];
+  const ssize_t end = ri->start + ri->len;
+  ssize_t i = ri->start;
+  ssize_t c = 0;
+  while (c < col && i < end) {
+    ssize_t cw;
+    const ssize_t next = str_next_ofs(s, end, i, &cw);
+    if (next <= 0) break;
+    i += next;
+    c += cw;
+  }
+  return i;
 }
 
 // get row/col for a given position
 ic_private ssize_t sbuf_get_rc_at_pos( stringbuf_t* sbuf, ssize_t termw, ssize_t promptw, ssize_t cpromptw, ssize_t pos, rowcol_t* rc ) {
-  return str_get_rc_at_pos( sbuf->buf, sbuf->count, termw, promptw, cpromptw, pos, rc);
+  const char* s = sbuf_cstr(sbuf);
+  if (!sbuf_layout_ensure(sbuf, termw, promptw, cpromptw)) {
+    return str_get_rc_at_pos( s, sbuf->count, termw, promptw, cpromptw, pos, rc);
+  }
+  memset(rc, 0, sizeof(*rc));
+  if (pos < 0) pos = 0;
+  if (pos > sbuf->count) pos = sbuf->count;
+  const ssize_t row = sbuf_layout_find_row(sbuf, pos);
+  const rowinfo_t* ri = &sbuf->rows[row];
+  rc->row_start = ri->start;
+  rc->row_len   = ri->len;
+  rc->row = row;
+  rc->col = str_column_width_n( s + ri->start, pos - ri->start );
+  rc->first_on_row = (pos == ri->start);
+  if (ri->is_wrap) {
+    // if wrapped, we check if the next character is at row_len
+    const ssize_t next = str_next_ofs(s, ri->start + ri->len, pos, NULL);
+    rc->last_on_row = (pos + next >= ri->start + ri->len);
+  }
+  else {
+    // normal last position is right after the last character
+    rc->last_on_row = (pos >= ri->start + ri->len);
+  }
+  return sbuf->rows_count;
+}
+
+// count the hard wraps of a row of `row_len` single-width characters that
+// does not contain the cursor; mirrors `str_get_current_wrapped_pos_iter`
+// where the column resets on each wrap, so the count follows arithmetically
+static ssize_t str_wrapped_row_hrows( ssize_t startw, ssize_t row_len, bool is_wrap, ssize_t newtermw ) {
+  ssize_t hrows = 0;
+  ssize_t hwidth = startw;
+  if (row_len > 0) {
+    hrows  = (startw + row_len - 1)/newtermw;  // wrap before a char when hwidth+1 > newtermw
+    hwidth = startw + row_len - hrows*newtermw;
+  }
+  const ssize_t cw = (is_wrap ? 2 : 0);  // end of row: the back-arrow of a soft wrap
+  if (hwidth + cw > newtermw) { hrows++; }
+  return hrows;
 }
 
 ic_private ssize_t sbuf_get_wrapped_rc_at_pos( stringbuf_t* sbuf, ssize_t termw, ssize_t newtermw, ssize_t promptw, ssize_t cpromptw, ssize_t pos, rowcol_t* rc ) {
-  return str_get_wrapped_rc_at_pos( sbuf->buf, sbuf->count, termw, newtermw, promptw, cpromptw, pos, rc);
+  const char* s = sbuf_cstr(sbuf);
+  if (newtermw <= 0 || !sbuf_layout_ensure(sbuf, termw, promptw, cpromptw)) {
+    return str_get_wrapped_rc_at_pos( s, sbuf->count, termw, newtermw, promptw, cpromptw, pos, rc);
+  }
+  // walk the cached rows instead of rewrapping the whole buffer; rows of
+  // plain ASCII without the cursor contribute their hard-wrap count
+  // arithmetically and only the row(s) around the cursor are scanned
+  wrapped_arg_t warg;
+  warg.pos = pos;
+  warg.newtermw = newtermw;
+  wrowcol_t wrc;
+  memset(&wrc, 0, sizeof(wrc));
+  for (ssize_t row = 0; row < sbuf->rows_count; row++) {
+    const rowinfo_t* ri = &sbuf->rows[row];
+    const ssize_t startw = (row == 0 ? promptw : cpromptw);
+    if (startw < newtermw && (pos < ri->start || pos > ri->start + ri->len) &&
+        str_ascii_run(s, ri->start + ri->len, ri->start) >= ri->len) {
+      wrc.hrows += str_wrapped_row_hrows(startw, ri->len, ri->is_wrap, newtermw);
+    }
+    else {
+      str_get_current_wrapped_pos_iter(s, row, ri->start, ri->len, startw, ri->is_wrap, &warg, &wrc);
+    }
+  }
+  *rc = wrc.rc;
+  return (sbuf->rows_count + wrc.hrows);
 }
 
 ic_private ssize_t sbuf_for_each_row( stringbuf_t* sbuf, ssize_t termw, ssize_t promptw, ssize_t cpromptw, row_fun_t* fun, void* arg, void* res ) {
   if (sbuf == NULL) return 0;
-  return str_for_each_row( sbuf->buf, sbuf->count, termw, promptw, cpromptw, fun, arg, res);
+  const char* s = sbuf_cstr(sbuf);
+  if (!sbuf_layout_ensure(sbuf, termw, promptw, cpromptw)) {
+    return str_for_each_row( s, sbuf->count, termw, promptw, cpromptw, fun, arg, res);
+  }
+  for (ssize_t row = 0; row < sbuf->rows_count; row++) {
+    const rowinfo_t* ri = &sbuf->rows[row];
+    const ssize_t startw = (row == 0 ? promptw : cpromptw);
+    if (fun != NULL) {
+      if (fun(s, row, ri->start, ri->len, startw, ri->is_wrap, arg, res)) return row;
+    }
+  }
+  return sbuf->rows_count;
 }
 
 
@@ -850,24 +1267,25 @@ ic_private char* sbuf_strdup_from_utf8(stringbuf_t* sbuf) {
   if (sbuf == NULL || len <= 0) return NULL;
   char* s = mem_zalloc_tp_n(sbuf->mem, char, len);
   if (s == NULL) return NULL;
+  const char* src = sbuf_cstr(sbuf);
   ssize_t dest = 0;
   for (ssize_t i = 0; i < len; ) {
-    ssize_t ofs = sbuf_next_ofs(sbuf, i, NULL);
+    ssize_t ofs = str_next_ofs(src, len, i, NULL);
     if (ofs <= 0) {
       // invalid input
       break;
     }
     else if (ofs == 1) {
       // regular character
-      s[dest++] = sbuf->buf[i];
+      s[dest++] = src[i];
     }
-    else if (sbuf->buf[i] == '\x1B') {
+    else if (src[i] == '\x1B') {
       // skip escape sequences
     }
     else {
       // decode unicode
       ssize_t nread;
-      unicode_t uchr = unicode_from_qutf8( (const uint8_t*)(sbuf->buf + i), ofs, &nread);
+      unicode_t uchr = unicode_from_qutf8( (const uint8_t*)(src + i), ofs, &nread);
       uint8_t c;
       if (unicode_is_raw(uchr, &c)) {
         // raw byte, output as is (this will take care of locale specific input)
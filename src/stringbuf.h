@@ -23,6 +23,9 @@ typedef struct stringbuf_s stringbuf_t;
 
 ic_private stringbuf_t*  sbuf_new( alloc_t* mem );
 ic_private void    sbuf_free( stringbuf_t* sbuf );
+ic_private void    sbuf_set_gap_buffer( stringbuf_t* sbuf, bool enable );  // gap-buffer mode for heavily edited buffers
+ic_private ssize_t sbuf_edited_at(const stringbuf_t* sbuf);  // lowest byte position edited since the last reset (-1 if unedited)
+ic_private void    sbuf_edit_reset(stringbuf_t* sbuf);
 ic_private char*   sbuf_free_dup(stringbuf_t* sbuf);
 ic_private ssize_t sbuf_len(const stringbuf_t* s);
 
@@ -113,6 +116,7 @@ ic_private ssize_t sbuf_for_each_row( stringbuf_t* sbuf, ssize_t termw, ssize_t
 ic_private bool    skip_csi_esc( const char* s, ssize_t len, ssize_t* esclen ); // used in term.c
 
 ic_private ssize_t str_column_width( const char* s );
+ic_private ssize_t str_column_width_n( const char* s, ssize_t len );
 ic_private ssize_t str_prev_ofs( const char* s, ssize_t pos, ssize_t* cwidth );
 ic_private ssize_t str_next_ofs( const char* s, ssize_t len, ssize_t pos, ssize_t* cwidth );
 ic_private ssize_t str_skip_until_fit( const char* s, ssize_t max_width);  // tail that fits
@@ -22,6 +22,8 @@
 #include <unistd.h>
 #include <errno.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h> // chmod
+#include <sys/uio.h>  // writev
 #if defined(__linux__)
 #include <linux/kd.h>
 #endif
@@ -38,6 +40,16 @@ typedef enum palette_e {
   ANSIRGB      // direct rgb colors supported (ESC[38;2;<r>;<g>;<b>m)
 } palette_t;
 
+// cache of recently composed SGR sequences (see `term_set_attr`)
+#define IC_SGR_CACHE_LEN  (16)
+#define IC_SGR_MAX        (80)   // fits an rgb fore- and background color plus all toggles
+
+typedef struct sgr_cached_s {
+  uint64_t from;              // attr value before
+  uint64_t to;                // requested attr value
+  char     seq[IC_SGR_MAX];   // composed escape sequence
+} sgr_cached_t;
+
 // The terminal screen
 struct term_s {
   int           fd_out;             // output handle
@@ -51,6 +63,8 @@ struct term_s {
   palette_t     palette;            // color support
   buffer_mode_t bufmode;            // buffer mode
   stringbuf_t*  buf;                // buffer for buffered output
+  sgr_cached_t  sgr_cache[IC_SGR_CACHE_LEN];  // recently composed SGR sequences
+  ssize_t       sgr_cache_idx;      // round-robin replacement index
   tty_t*        tty;                // used on posix to get the cursor position
   alloc_t*      mem;                // allocator
   #ifdef _WIN32
@@ -65,8 +79,12 @@ struct term_s {
 };
 
 static bool term_write_direct(term_t* term, const char* s, ssize_t n );
+static bool term_write_direct_v(term_t* term, const char* s1, ssize_t n1, const char* s2, ssize_t n2 );
 static void term_append_buf(term_t* term, const char* s, ssize_t n);
 
+#define IC_TERM_FLUSH_SIZE   (16*1024)  // flush threshold in line-buffered mode
+#define IC_TERM_WRITEV_SIZE  (4*1024)   // write spans at least this large without copying them into the buffer
+
 //-------------------------------------------------------------
 // Colors
 //-------------------------------------------------------------
@@ -153,38 +171,80 @@ ic_private attr_t term_get_attr( const term_t* term ) {
   return term->attr;
 }
 
+// append to the composed sequence (bounded)
+static void sgr_append_n( char* seq, ssize_t size, ssize_t* pos, const char* s, ssize_t len ) {
+  if (len <= 0 || *pos + len >= size) return;
+  ic_memcpy(seq + *pos, s, len);
+  *pos += len;
+  seq[*pos] = 0;
+}
+
+// append the parameters of an SGR piece (strips the CSI introducer and final 'm')
+static void sgr_append_params( char* seq, ssize_t size, ssize_t* pos, const char* piece ) {
+  if (piece[0] == 0) return;
+  const ssize_t n = ic_strlen(piece);
+  assert(piece[0] == '\x1B' && piece[1] == '[' && piece[n-1] == 'm');
+  if (n <= 3) return;
+  if (*pos > 2) { sgr_append_n(seq, size, pos, ";", 1); }  // separate from previous params
+  sgr_append_n(seq, size, pos, piece + 2, n - 3);
+}
+
+// set the text attributes; emits one combined SGR sequence with only the
+// parameters for the fields that actually change (a minimal delta), and
+// caches the composed sequence for recent attribute transitions.
 ic_private void term_set_attr( term_t* term, attr_t attr ) {
   if (term->nocolor) return;
-  if (attr.x.color != term->attr.x.color && attr.x.color != IC_COLOR_NONE) {
-    term_color(term,attr.x.color);
-    if (term->palette < ANSIRGB && color_is_rgb(attr.x.color)) {
-      term->attr.x.color = attr.x.color; // actual color may have been approximated but we keep the actual color to avoid updating every time
+  const attr_t cur = term->attr;
+  const bool upd_color     = (attr.x.color != cur.x.color && attr.x.color != IC_COLOR_NONE);
+  const bool upd_bgcolor   = (attr.x.bgcolor != cur.x.bgcolor && attr.x.bgcolor != IC_COLOR_NONE);
+  const bool upd_bold      = (attr.x.bold != cur.x.bold && attr.x.bold != IC_NONE);
+  const bool upd_underline = (attr.x.underline != cur.x.underline && attr.x.underline != IC_NONE);
+  const bool upd_reverse   = (attr.x.reverse != cur.x.reverse && attr.x.reverse != IC_NONE);
+  const bool upd_italic    = (attr.x.italic != cur.x.italic && attr.x.italic != IC_NONE);
+  if (!(upd_color || upd_bgcolor || upd_bold || upd_underline || upd_reverse || upd_italic)) return;
+  // cached?
+  sgr_cached_t* cached = NULL;
+  for (ssize_t i = 0; i < IC_SGR_CACHE_LEN; i++) {
+    if (term->sgr_cache[i].from == cur.value && term->sgr_cache[i].to == attr.value) {
+      cached = &term->sgr_cache[i];
+      break;
     }
   }
-  if (attr.x.bgcolor != term->attr.x.bgcolor && attr.x.bgcolor != IC_COLOR_NONE) {
-    term_bgcolor(term,attr.x.bgcolor);
-    if (term->palette < ANSIRGB && color_is_rgb(attr.x.bgcolor)) {
-      term->attr.x.bgcolor = attr.x.bgcolor; 
+  if (cached == NULL) {
+    // compose one combined sequence: ESC[<p1>;<p2>;..m
+    char seq[IC_SGR_MAX];
+    char piece[128+1];
+    ssize_t pos = 0;
+    sgr_append_n(seq, IC_SGR_MAX, &pos, IC_CSI, 2);
+    if (upd_color) {
+      piece[0] = 0;
+      fmt_color_ex(piece, 128, term->palette, attr.x.color, false);
+      sgr_append_params(seq, IC_SGR_MAX, &pos, piece);
     }
+    if (upd_bgcolor) {
+      piece[0] = 0;
+      fmt_color_ex(piece, 128, term->palette, attr.x.bgcolor, true);
+      sgr_append_params(seq, IC_SGR_MAX, &pos, piece);
+    }
+    if (upd_bold)      { snprintf(piece, 128, IC_CSI "%sm", attr.x.bold == IC_ON ? "1" : "22");      sgr_append_params(seq, IC_SGR_MAX, &pos, piece); }
+    if (upd_underline) { snprintf(piece, 128, IC_CSI "%sm", attr.x.underline == IC_ON ? "4" : "24"); sgr_append_params(seq, IC_SGR_MAX, &pos, piece); }
+    if (upd_reverse)   { snprintf(piece, 128, IC_CSI "%sm", attr.x.reverse == IC_ON ? "7" : "27");   sgr_append_params(seq, IC_SGR_MAX, &pos, piece); }
+    if (upd_italic)    { snprintf(piece, 128, IC_CSI "%sm", attr.x.italic == IC_ON ? "3" : "23");    sgr_append_params(seq, IC_SGR_MAX, &pos, piece); }
+    if (pos <= 2) return;  // nothing to emit (e.g. monochrome palette)
+    sgr_append_n(seq, IC_SGR_MAX, &pos, "m", 1);
+    // remember it (round-robin)
+    cached = &term->sgr_cache[term->sgr_cache_idx];
+    term->sgr_cache_idx = (term->sgr_cache_idx + 1) % IC_SGR_CACHE_LEN;
+    cached->from = cur.value;
+    cached->to = attr.value;
+    ic_strcpy(cached->seq, IC_SGR_MAX, seq);
   }
-  if (attr.x.bold != term->attr.x.bold && attr.x.bold != IC_NONE) {
-    term_bold(term,attr.x.bold == IC_ON);
-  }
-  if (attr.x.underline != term->attr.x.underline && attr.x.underline != IC_NONE) {
-    term_underline(term,attr.x.underline == IC_ON);
-  }
-  if (attr.x.reverse != term->attr.x.reverse && attr.x.reverse != IC_NONE) {
-    term_reverse(term,attr.x.reverse == IC_ON);
+  term_write(term, cached->seq);  // updates term->attr as the sequence is parsed on write
+  if (term->palette < ANSIRGB) {
+    // actual color may have been approximated but we keep the requested color to avoid updating every time
+    if (upd_color && color_is_rgb(attr.x.color))     { term->attr.x.color = attr.x.color; }
+    if (upd_bgcolor && color_is_rgb(attr.x.bgcolor)) { term->attr.x.bgcolor = attr.x.bgcolor; }
   }
-  if (attr.x.italic != term->attr.x.italic && attr.x.italic != IC_NONE) {
-    term_italic(term,attr.x.italic == IC_ON);
-  }  
-  assert(attr.x.color == term->attr.x.color || attr.x.color == IC_COLOR_NONE);
-  assert(attr.x.bgcolor == term->attr.x.bgcolor || attr.x.bgcolor == IC_COLOR_NONE);
-  assert(attr.x.bold == term->attr.x.bold || attr.x.bold == IC_NONE);
-  assert(attr.x.reverse == term->attr.x.reverse || attr.x.reverse == IC_NONE);
-  assert(attr.x.underline == term->attr.x.underline || attr.x.underline == IC_NONE);
-  assert(attr.x.italic == term->attr.x.italic || attr.x.italic == IC_NONE);
 }
 
 
@@ -254,6 +314,34 @@ ic_private void term_write_formatted_n( term_t* term, const char* s, const attr_
   }
 }
 
+// write `s[0..len)` with the attributes from `ab` starting at byte `pos`;
+// walks whole runs of identical attributes instead of comparing per byte.
+ic_private void term_write_formatted_runs( term_t* term, const char* s, const attrbuf_t* ab, ssize_t pos, ssize_t len ) {
+  if (ab == NULL) {
+    term_write_n(term,s,len);
+    return;
+  }
+  // ensure raw mode from now on
+  if (term->raw_enabled <= 0) {
+    term_start_raw(term);
+  }
+  // and output run by run
+  const attr_t default_attr = term_get_attr(term);
+  attrbuf_iter_t iter;
+  attrbuf_iter_start(ab, pos, &iter);
+  attr_t attr;
+  ssize_t n;
+  ssize_t i = 0;
+  while (i < len && attrbuf_iter_next(&iter, &attr, &n)) {
+    if (n > len - i) { n = len - i; }
+    term_set_attr( term, attr_update_with(default_attr,attr) );
+    term_write_n( term, s+i, n );
+    i += n;
+  }
+  if (i < len) { term_write_n( term, s+i, len-i ); }  // no attributes past the end
+  term_set_attr(term, default_attr);
+}
+
 //-------------------------------------------------------------
 // Write to the terminal
 // The buffered functions are used to reduce cursor flicker
@@ -293,11 +381,22 @@ ic_private void term_write_n(term_t* term, const char* s, ssize_t n) {
 
 ic_private void term_flush(term_t* term) {
   if (sbuf_len(term->buf) > 0) {
+    ic_stats_timed_begin();
     //term_show_cursor(term,false);
     term_write_direct(term, sbuf_string(term->buf), sbuf_len(term->buf));
     //term_show_cursor(term,true);
     sbuf_clear(term->buf);
-  }  
+    ic_stats_timed_end(term_flush_count, term_flush_nsecs);
+  }
+}
+
+// Flush the buffer together with a large caller-provided span using a single
+// vectored write so the span is never copied into the buffer.
+static void term_flush_with(term_t* term, const char* s, ssize_t n) {
+  ic_stats_timed_begin();
+  term_write_direct_v(term, sbuf_string(term->buf), sbuf_len(term->buf), s, n);
+  sbuf_clear(term->buf);
+  ic_stats_timed_end(term_flush_count, term_flush_nsecs);
 }
 
 ic_private buffer_mode_t term_set_buffer_mode(term_t* term, buffer_mode_t mode) {
@@ -312,12 +411,14 @@ ic_private buffer_mode_t term_set_buffer_mode(term_t* term, buffer_mode_t mode)
 }
 
 static void term_check_flush(term_t* term, bool contains_nl) {
-  if (term->bufmode == UNBUFFERED || 
-      sbuf_len(term->buf) > 4000 ||
-      (term->bufmode == LINEBUFFERED && contains_nl)) 
+  // in BUFFERED mode (a refresh frame) we never flush early so a full
+  // frame is always written with a single syscall in `term_flush`.
+  if (term->bufmode == UNBUFFERED ||
+      (term->bufmode == LINEBUFFERED && sbuf_len(term->buf) > IC_TERM_FLUSH_SIZE) ||
+      (term->bufmode == LINEBUFFERED && contains_nl))
   {
     term_flush(term);
-  }  
+  }
 }
 
 //-------------------------------------------------------------
@@ -416,6 +517,10 @@ ic_private bool term_is_interactive(const term_t* term) {
   return true;
 }
 
+ic_private tty_t* term_get_tty(term_t* term) {
+  return term->tty;  // can be NULL
+}
+
 ic_private bool term_enable_beep(term_t* term, bool enable) {
   bool prev = term->silent;
   term->silent = !enable;
@@ -488,7 +593,12 @@ static void term_append_buf( term_t* term, const char* s, ssize_t len ) {
       ascii += next;      
     }
     if (ascii > 0) {
-      sbuf_append_n(term->buf, s+pos, ascii);
+      if (term->bufmode != BUFFERED && ascii >= IC_TERM_WRITEV_SIZE) {
+        term_flush_with(term, s+pos, ascii);  // write large spans without copying
+      }
+      else {
+        sbuf_append_n(term->buf, s+pos, ascii);
+      }
       pos += ascii;
     }
     if (next <= 0) break;
@@ -523,10 +633,12 @@ static void term_append_buf( term_t* term, const char* s, ssize_t len ) {
 
 // write to the console without further processing
 static bool term_write_direct(term_t* term, const char* s, ssize_t n) {
-  ssize_t count = 0; 
+  ssize_t count = 0;
   while( count < n ) {
     ssize_t nwritten = write(term->fd_out, s + count, to_size_t(n - count));
     if (nwritten > 0) {
+      ic_stats_count(term_write_count, 1);
+      ic_stats_count(term_write_bytes, nwritten);
       count += nwritten;
     }
     else if (errno != EINTR && errno != EAGAIN) {
@@ -537,6 +649,40 @@ static bool term_write_direct(term_t* term, const char* s, ssize_t n) {
   return true;
 }
 
+// write two spans to the console with a single vectored write
+static bool term_write_direct_v(term_t* term, const char* s1, ssize_t n1, const char* s2, ssize_t n2) {
+  if (n1 < 0) { n1 = 0; }
+  if (n2 < 0) { n2 = 0; }
+  const ssize_t total = n1 + n2;
+  ssize_t count = 0;
+  while (count < total) {
+    struct iovec iov[2];
+    int iovcnt = 0;
+    if (count < n1) {
+      iov[iovcnt].iov_base = (void*)(s1 + count);
+      iov[iovcnt].iov_len  = to_size_t(n1 - count);
+      iovcnt++;
+    }
+    const ssize_t ofs2 = (count > n1 ? count - n1 : 0);
+    if (ofs2 < n2) {
+      iov[iovcnt].iov_base = (void*)(s2 + ofs2);
+      iov[iovcnt].iov_len  = to_size_t(n2 - ofs2);
+      iovcnt++;
+    }
+    ssize_t nwritten = writev(term->fd_out, iov, iovcnt);
+    if (nwritten > 0) {
+      ic_stats_count(term_write_count, 1);
+      ic_stats_count(term_write_bytes, nwritten);
+      count += nwritten;
+    }
+    else if (errno != EINTR && errno != EAGAIN) {
+      debug_msg("term: vectored write failed: length %zd, errno %i\n", total, errno);
+      return false;
+    }
+  }
+  return true;
+}
+
 #else
 
 //----------------------------------------------------------------------------------
@@ -810,52 +956,57 @@ static void term_write_esc( term_t* term, const char* s, ssize_t len ) {
 }
 
 static bool term_write_direct(term_t* term, const char* s, ssize_t len ) {
-  term_cursor_visible(term,false); // reduce flicker
-  ssize_t pos = 0;    
+  ic_stats_count(term_write_count, 1);
+  ic_stats_count(term_write_bytes, len);
+  ssize_t pos = 0;
   if ((term->hcon_mode & ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0) {
-    // use the builtin virtual terminal processing. (enables truecolor for example)
-    term_write_console(term, s, len);   
+    // use the builtin virtual terminal processing; the whole (buffered) span
+    // goes out verbatim in a single console call. (enables truecolor for example)
+    term_write_console(term, s, len);
     pos = len;
   }
   else {
-    // emulate escape sequences
+    // emulate escape sequences; batch everything between escape sequences into a
+    // single console call so a refresh issues one write per attribute run instead
+    // of one per utf-8 sequence or control character.
+    // (We don't need to handle utf-8 separately as we set the codepage to always be in utf-8 mode)
+    term_cursor_visible(term,false); // reduce flicker
     while( pos < len ) {
-      // handle non-control in bulk (including utf-8 sequences)
-      // (We don't need to handle utf-8 separately as we set the codepage to always be in utf-8 mode)
-      ssize_t nonctrl = 0;
+      ssize_t run = 0;
       ssize_t next;
-      while( (next = str_next_ofs( s, len, pos+nonctrl, NULL )) > 0 && 
-              (uint8_t)s[pos + nonctrl] >= ' ' && (uint8_t)s[pos + nonctrl] <= 0x7F) {
-        nonctrl += next;
+      while( (next = str_next_ofs( s, len, pos+run, NULL )) > 0 ) {
+        const uint8_t c = (uint8_t)s[pos + run];
+        if (c < ' ' && c != '\r' && c != '\n' && c != '\t' && c != '\b') break;  // escape sequence or ignored control
+        run += next;
+      }
+      if (run > 0) {
+        term_write_console(term, s+pos, run);
+        pos += run;
       }
-      if (nonctrl > 0) {
-        term_write_console(term, s+pos, nonctrl);
-        pos += nonctrl;
-      }    
       if (next <= 0) break;
 
-      if ((uint8_t)s[pos] >= 0x80) {
-        // utf8 is already processed
-        term_write_console(term, s+pos, next);
-      }
-      else if (next > 1 && s[pos] == '\x1B') {                                
+      if (next > 1 && s[pos] == '\x1B') {
         // handle control (note: str_next_ofs considers whole CSI escape sequences at a time)
         term_write_esc(term, s+pos, next);
       }
-      else if (next == 1 && (s[pos] == '\r' || s[pos] == '\n' || s[pos] == '\t' || s[pos] == '\b')) {
-        term_write_console( term, s+pos, next);
-      }
       else {
-        // ignore
+        // ignore other control characters
       }
       pos += next;
     }
+    term_cursor_visible(term,true);
   }
-  term_cursor_visible(term,true);
   assert(pos == len);
-  return (pos == len); 
+  return (pos == len);
 
 }
+
+// no vectored writes on the windows console; write the spans in sequence
+static bool term_write_direct_v(term_t* term, const char* s1, ssize_t n1, const char* s2, ssize_t n2) {
+  bool ok = (n1 <= 0 || term_write_direct(term, s1, n1));
+  if (n2 > 0) { ok = term_write_direct(term, s2, n2) && ok; }
+  return ok;
+}
 #endif
 
 
@@ -971,7 +1122,10 @@ ic_private bool term_update_dim(term_t* term) {
 // On non-windows, the terminal is set in raw mode by the tty.
 
 ic_private void term_start_raw(term_t* term) {
-  term->raw_enabled++;
+  if (term->raw_enabled++ == 0 && isatty(term->fd_out)) {
+    // enable bracketed paste so a paste can be inserted as one edit operation
+    term_write_direct(term, IC_CSI "?2004h", 8);
+  }
 }
 
 ic_private void term_end_raw(term_t* term, bool force) {
@@ -982,6 +1136,99 @@ ic_private void term_end_raw(term_t* term, bool force) {
   else {
     term->raw_enabled = 0;
   }
+  if (term->raw_enabled == 0 && isatty(term->fd_out)) {
+    term_write_direct(term, IC_CSI "?2004l", 8);
+  }
+}
+
+//-------------------------------------------------------------
+// Capability cache
+// Probing the palette can need escape queries where each query
+// waits (with a timeout) for the terminal response -- and this
+// runs on every process start. Cache the probed colors in a
+// small file keyed by the terminal identity so subsequent
+// startups skip the round-trips; re-probe only when the key
+// changes. Delete the cache file (or set ISOCLINE_NO_TERM_CACHE)
+// to force a fresh probe.
+//-------------------------------------------------------------
+
+#define IC_TERM_CACHE_VERSION  (1)
+
+static bool term_cache_enabled(void) {
+  return (getenv("ISOCLINE_NO_TERM_CACHE") == NULL);
+}
+
+static bool term_cache_path( char* buf, size_t buflen ) {
+  const char* dir = getenv("XDG_CACHE_HOME");
+  if (dir != NULL && dir[0] != 0) {
+    snprintf(buf, buflen, "%s/isocline-term.cache", dir);
+  }
+  else {
+    const char* home = getenv("HOME");
+    if (home == NULL || home[0] == 0) return false;
+    snprintf(buf, buflen, "%s/.cache/isocline-term.cache", home);
+  }
+  return true;
+}
+
+// identify the terminal we talk to; the TERM_PROGRAM[_VERSION] variables
+// carry the terminal-reported version so an upgraded terminal re-probes.
+static void term_cache_key( const term_t* term, char* buf, size_t buflen ) {
+  const char* eterm   = getenv("TERM");
+  const char* cterm   = getenv("COLORTERM");
+  const char* program = getenv("TERM_PROGRAM");
+  const char* version = getenv("TERM_PROGRAM_VERSION");
+  const char* dev     = ttyname(term->fd_out);
+  snprintf(buf, buflen, "%d|%s|%s|%s|%s|%s", IC_TERM_CACHE_VERSION,
+            (eterm==NULL ? "" : eterm), (cterm==NULL ? "" : cterm),
+            (program==NULL ? "" : program), (version==NULL ? "" : version),
+            (dev==NULL ? "" : dev));
+}
+
+// restore the probed ansi colors if the cache matches our terminal
+static bool term_cache_load( const term_t* term ) {
+  if (!term_cache_enabled()) return false;
+  char path[512];
+  if (!term_cache_path(path, 512)) return false;
+  FILE* f = fopen(path, "r");
+  if (f == NULL) return false;
+  char key[512];
+  term_cache_key(term, key, 512);
+  char line[512];
+  bool ok = (fgets(line, 512, f) != NULL);
+  if (ok) {
+    line[strcspn(line, "\r\n")] = 0;
+    ok = (strcmp(line, key) == 0);
+  }
+  uint32_t colors[16];
+  for (ssize_t i = 0; i < 16 && ok; i++) {
+    unsigned int color;
+    ok = (fscanf(f, "%x", &color) == 1);
+    colors[i] = (uint32_t)color;
+  }
+  fclose(f);
+  if (!ok) return false;
+  for (ssize_t i = 0; i < 16; i++) {
+    ansi256[i] = colors[i];
+  }
+  debug_msg("term: capability cache hit: %s\n", key);
+  return true;
+}
+
+static void term_cache_save( const term_t* term ) {
+  if (!term_cache_enabled()) return;
+  char path[512];
+  if (!term_cache_path(path, 512)) return;
+  FILE* f = fopen(path, "w");
+  if (f == NULL) return;  // e.g. $HOME/.cache does not exist
+  chmod(path, S_IRUSR|S_IWUSR);
+  char key[512];
+  term_cache_key(term, key, 512);
+  fprintf(f, "%s\n", key);
+  for (ssize_t i = 0; i < 16; i++) {
+    fprintf(f, "%06x\n", (unsigned int)ansi256[i]);
+  }
+  fclose(f);
 }
 
 static bool term_esc_query_color_raw(term_t* term, int color_idx, uint32_t* color ) {
@@ -1010,6 +1257,7 @@ static bool term_esc_query_color_raw(term_t* term, int color_idx, uint32_t* colo
 // update ansi 16 color palette for better color approximation
 static void term_update_ansi16(term_t* term) {
   debug_msg("update ansi colors\n");
+  if (term_cache_load(term)) return;  // probed on an earlier startup
   #if defined(GIO_CMAP)
   // try ioctl first (on Linux)
   uint8_t cmap[48];
@@ -1021,6 +1269,7 @@ static void term_update_ansi16(term_t* term) {
       debug_msg("term (ioctl) ansi color %d: 0x%06x\n", i, color);
       ansi256[i] = color;
     }
+    term_cache_save(term);
     return;
   }
   else {
@@ -1037,9 +1286,10 @@ static void term_update_ansi16(term_t* term) {
       debug_msg("term ansi color %d: 0x%06x\n", i, color);
       ansi256[i] = color;
     }  
-    tty_end_raw(term->tty);  
+    tty_end_raw(term->tty);
   }
   #endif
+  term_cache_save(term);
 }
 
 static void term_init_raw(term_t* term) {
@@ -27,6 +27,7 @@ ic_private term_t* term_new(alloc_t* mem, tty_t* tty, bool nocolor, bool silent,
 ic_private void term_free(term_t* term);
 
 ic_private bool term_is_interactive(const term_t* term);
+ic_private tty_t* term_get_tty(term_t* term);   // can be NULL
 ic_private void term_start_raw(term_t* term);
 ic_private void term_end_raw(term_t* term, bool force);
 
@@ -79,6 +80,7 @@ ic_private attr_t term_get_attr( const term_t* term );
 ic_private void   term_set_attr( term_t* term, attr_t attr );
 ic_private void   term_write_formatted( term_t* term, const char* s, const attr_t* attrs );
 ic_private void   term_write_formatted_n( term_t* term, const char* s, const attr_t* attrs, ssize_t n );
+ic_private void   term_write_formatted_runs( term_t* term, const char* s, const attrbuf_t* ab, ssize_t pos, ssize_t len );
 
 ic_private ic_color_t color_from_ansi256(ssize_t i);
 
@@ -170,47 +170,13 @@ static int_least32_t rgb_distance_rbmean( uint32_t color, int r2, int g2, int b2
 }
 
 
-// Maintain a small cache of recently used colors. Should be short enough to be effectively constant time.
-// If we ever use a more expensive color distance method, we may increase the size a bit (64?) 
-// (Initial zero initialized cache is valid.)
-#define RGB_CACHE_LEN (16)
-typedef struct rgb_cache_s {
-  int        last;
-  int        indices[RGB_CACHE_LEN];
-  ic_color_t colors[RGB_CACHE_LEN];
-} rgb_cache_t;
-
-// remember a color in the LRU cache
-void rgb_remember( rgb_cache_t* cache, ic_color_t color, int idx ) {
-  if (cache == NULL) return;
-  cache->colors[cache->last] = color;
-  cache->indices[cache->last] = idx;
-  cache->last++;
-  if (cache->last >= RGB_CACHE_LEN) { cache->last = 0; }
-}
-
-// quick lookup in cache; -1 on failure
-int rgb_lookup( const rgb_cache_t* cache, ic_color_t color ) {
-  if (cache != NULL) {
-    for(int i = 0; i < RGB_CACHE_LEN; i++) {
-      if (cache->colors[i] == color) return cache->indices[i];
-    }
-  }
-  return -1;
-}
-
 // return the index of the closest matching color
-static int rgb_match( uint32_t* palette, int start, int len, rgb_cache_t* cache, ic_color_t color ) {
+static int rgb_match( uint32_t* palette, int start, int len, ic_color_t color ) {
   assert(color_is_rgb(color));
-  // in cache?
-  int min = rgb_lookup(cache,color);
-  if (min >= 0) {
-    return min;
-  }
-  // otherwise find closest color match in the palette
+  // find closest color match in the palette
   int r, g, b;
   color_to_rgb(color,&r,&g,&b);
-  min = start;
+  int min = start;
   int_least32_t mindist = (INT_LEAST32_MAX)/4;
   for(int i = start; i < len; i++) {
     //int_least32_t dist = rgb_distance_rbmean(palette[i],r,g,b);
@@ -229,15 +195,45 @@ static int rgb_match( uint32_t* palette, int start, int len, rgb_cache_t* cache,
       mindist = dist;
     }
   }
-  rgb_remember(cache,color,min);
   return min;
 }
 
 
+// Precomputed lookup tables mapping RGB quantized to 5 bits per channel to
+// the nearest palette index, so the mapping is a single array load. Entries
+// are filled on first use with the distance scan above as the generator
+// (a zero entry means "not yet computed"; stored as index - start + 1).
+#define RGB_LUT_BITS  (5)
+#define RGB_LUT_LEN   (1 << (3*RGB_LUT_BITS))   // 32768 entries, 32KiB per table
+
+static ssize_t rgb_lut_key(int r, int g, int b) {
+  return ((ssize_t)(r >> 3) << (2*RGB_LUT_BITS)) | ((ssize_t)(g >> 3) << RGB_LUT_BITS) | (ssize_t)(b >> 3);
+}
+
+// the representative color of a quantized channel (replicate the top bits)
+static int rgb_lut_channel(ssize_t key, int shift) {
+  const int q = (int)((key >> shift) & 0x1F);
+  return ((q << 3) | (q >> 2));
+}
+
+static int rgb_match_lut( uint32_t* palette, int start, int len, uint8_t* lut, ic_color_t color ) {
+  int r, g, b;
+  color_to_rgb(color,&r,&g,&b);
+  const ssize_t key = rgb_lut_key(r,g,b);
+  if (lut[key] == 0) {
+    // not yet computed: run the distance scan once for this quantized color
+    const ic_color_t qcolor = ic_rgbx( rgb_lut_channel(key,2*RGB_LUT_BITS),
+                                       rgb_lut_channel(key,RGB_LUT_BITS),
+                                       rgb_lut_channel(key,0) );
+    lut[key] = (uint8_t)(rgb_match(palette, start, len, qcolor) - start + 1);
+  }
+  return ((int)(lut[key]) - 1 + start);
+}
+
 // Match RGB to an index in the ANSI 256 color table
 static int rgb_to_ansi256(ic_color_t color) {
-  static rgb_cache_t ansi256_cache;
-  int c = rgb_match(ansi256, 16, 256, &ansi256_cache, color); // not the first 16 ANSI colors as those may be different 
+  static uint8_t ansi256_lut[RGB_LUT_LEN];
+  int c = rgb_match_lut(ansi256, 16, 256, ansi256_lut, color); // not the first 16 ANSI colors as those may be different
   //debug_msg("term: rgb %x -> ansi 256: %d\n", color, c );
   return c;
 }
@@ -248,10 +244,10 @@ static int color_to_ansi16(ic_color_t color) {
     return (int)color;
   }
   else {
-    static rgb_cache_t ansi16_cache;
-    int c = rgb_match(ansi256, 0, 16, &ansi16_cache, color);
+    static uint8_t ansi16_lut[RGB_LUT_LEN];
+    int c = rgb_match_lut(ansi256, 0, 16, ansi16_lut, color);
     //debug_msg("term: rgb %x -> ansi 16: %d\n", color, c );
-    return (c < 8 ? 30 + c : 90 + c - 8); 
+    return (c < 8 ? 30 + c : 90 + c - 8);
   }
 }
 
@@ -263,8 +259,8 @@ static int color_to_ansi8(ic_color_t color) {
   }
   else {
     // match to basic 8 colors first
-    static rgb_cache_t ansi8_cache;
-    int c = 30 + rgb_match(ansi256, 0, 8, &ansi8_cache, color);
+    static uint8_t ansi8_lut[RGB_LUT_LEN];
+    int c = 30 + rgb_match_lut(ansi256, 0, 8, ansi8_lut, color);
     // and then adjust for brightness
     int r, g, b;
     color_to_rgb(color,&r,&g,&b);
@@ -154,8 +154,13 @@ ic_private bool tty_read_timeout(tty_t* tty, long timeout_ms, code_t* code)
 
   // read a single char/byte from a character stream
   uint8_t c;
-  if (!tty_readc_noblock(tty, &c, timeout_ms)) return false;
-  
+  ic_stats_timed_begin();
+  if (!tty_readc_noblock(tty, &c, timeout_ms)) {
+    ic_stats_timed_end(tty_read_count, tty_read_nsecs);
+    return false;
+  }
+  ic_stats_timed_end(tty_read_count, tty_read_nsecs);
+
   if (c == KEY_ESC) {
     // escape sequence?
     *code = tty_read_esc(tty, tty->esc_initial_timeout, tty->esc_timeout);
@@ -271,6 +276,37 @@ ic_private bool tty_read_esc_response(tty_t* tty, char esc_start, bool final_st,
   return true;
 }
 
+//-------------------------------------------------------------
+// Read the contents of a bracketed paste
+//-------------------------------------------------------------
+
+// Read the bytes of a bracketed paste up to (and excluding) the terminating
+// `ESC [ 201 ~` marker; the start marker was already decoded as KEY_EVENT_PASTE_START.
+// Returns false if the end marker was never seen (and the read timed out).
+ic_private bool tty_read_bracketed_paste(tty_t* tty, stringbuf_t* sbuf) {
+  static const char paste_end[] = "\x1B[201~";
+  ssize_t matched = 0;
+  uint8_t c = 0;
+  // a paste arrives as a burst so a timeout only happens on a missing end marker
+  while (tty_readc_noblock(tty, &c, tty->esc_initial_timeout)) {
+    if ((char)c == paste_end[matched]) {
+      matched++;
+      if (paste_end[matched] == 0) return true;  // seen the full end marker
+    }
+    else {
+      if (matched > 0) {
+        sbuf_append_n(sbuf, paste_end, matched); // partially matched bytes were content after all
+        matched = 0;
+        if ((char)c == paste_end[0]) { matched = 1; continue; }
+      }
+      sbuf_append_char(sbuf, (char)c);
+    }
+  }
+  if (matched > 0) { sbuf_append_n(sbuf, paste_end, matched); }
+  debug_msg("tty: bracketed paste without end marker (%zd bytes)\n", sbuf_len(sbuf));
+  return false;
+}
+
 //-------------------------------------------------------------
 // High level code pushback
 //-------------------------------------------------------------
@@ -282,13 +318,39 @@ static bool tty_code_pop( tty_t* tty, code_t* code ) {
   return true;
 }
 
-ic_private void tty_code_pushback( tty_t* tty, code_t c ) {   
+ic_private void tty_code_pushback( tty_t* tty, code_t c ) {
   // note: must be signal safe
   if (tty->push_count >= TTY_PUSH_MAX) return;
   tty->pushbuf[tty->push_count] = c;
   tty->push_count++;
 }
 
+ic_private int tty_get_fd(const tty_t* tty) {
+  #if defined(_WIN32)
+  ic_unused(tty);
+  return -1;  // the console input handle cannot be waited on as a file descriptor
+  #else
+  if (tty == NULL) return -1;
+  return tty->fd_in;
+  #endif
+}
+
+// Feed input bytes as if they were typed (see `ic_readline_feed`).
+ic_private ssize_t tty_feed(tty_t* tty, const char* s, ssize_t n) {
+  if (tty == NULL || s == NULL || n <= 0) return 0;
+  const ssize_t can = TTY_PUSH_MAX - tty->cpush_count;
+  if (n > can) { n = can; }
+  if (n <= 0) return 0;
+  // bytes already pushed back stay on top (they pop first); the fed bytes go
+  // beneath them in reverse order so they pop in stream order afterwards
+  ic_memmove(tty->cpushbuf + n, tty->cpushbuf, tty->cpush_count);
+  for (ssize_t i = 0; i < n; i++) {
+    tty->cpushbuf[n - 1 - i] = (uint8_t)s[i];
+  }
+  tty->cpush_count += n;
+  return n;
+}
+
 
 //-------------------------------------------------------------
 // low-level character pushback (for escape sequences and windows)
@@ -451,9 +513,27 @@ static bool tty_readc_blocking(tty_t* tty, uint8_t* c) {
   return (nread == 1);
 }
 
+#if defined(FIONREAD)
+// Read all available bytes with a single `read` and push the extra ones in the
+// pushback buffer; this way decoding escape sequences (or a fast paste) does
+// not use a syscall per byte. (Only called when the pushback buffer is empty.)
+static bool tty_readc_bulk(tty_t* tty, uint8_t* c, int navail) {
+  assert(tty->cpush_count == 0);
+  uint8_t buf[TTY_PUSH_MAX];
+  const ssize_t n = (navail > TTY_PUSH_MAX ? TTY_PUSH_MAX : (ssize_t)navail);
+  const ssize_t nread = read(tty->fd_in, (char*)buf, to_size_t(n));
+  if (nread <= 0) return false;
+  *c = buf[0];
+  for (ssize_t i = 1; i < nread; i++) {
+    tty->cpushbuf[nread - 1 - i] = buf[i];  // in reverse, so they pop in stream order
+  }
+  tty->cpush_count = nread - 1;
+  return true;
+}
+#endif
 
 // non blocking read -- with a small timeout used for reading escape sequences.
-ic_private bool tty_readc_noblock(tty_t* tty, uint8_t* c, long timeout_ms) 
+ic_private bool tty_readc_noblock(tty_t* tty, uint8_t* c, long timeout_ms)
 {
   // in our pushback buffer?
   if (tty_cpop(tty, c)) return true;
@@ -466,8 +546,11 @@ ic_private bool tty_readc_noblock(tty_t* tty, uint8_t* c, long timeout_ms)
   // if supported, peek first if any char is available.
   #if defined(FIONREAD)
   { int navail = 0;
-    if (ioctl(0, FIONREAD, &navail) == 0) {
-      if (navail >= 1) {
+    if (ioctl(tty->fd_in, FIONREAD, &navail) == 0) {
+      if (navail > 1) {
+        return tty_readc_bulk(tty, c, navail);  // read the whole chunk at once
+      }
+      else if (navail == 1) {
         return tty_readc_blocking(tty, c);
       }
       else if (timeout_ms == 0) {
@@ -529,7 +612,32 @@ ic_private bool tty_readc_noblock(tty_t* tty, uint8_t* c, long timeout_ms)
   return false;
 }
 
-#if defined(TIOCSTI) 
+// Is input available right now? (without consuming any)
+// Used to cancel background work -- like hint generation -- when the
+// user keeps typing.
+ic_private bool tty_has_input(tty_t* tty) {
+  if (tty == NULL) return false;
+  if (tty->cpush_count > 0 || tty->push_count > 0) return true;
+  #if defined(FIONREAD)
+  { int navail = 0;
+    if (ioctl(tty->fd_in, FIONREAD, &navail) == 0) { return (navail > 0); }
+  }
+  #endif
+  #if defined(FD_SET)
+  { fd_set readset;
+    struct timeval time;
+    FD_ZERO(&readset);
+    FD_SET(tty->fd_in, &readset);
+    time.tv_sec  = 0;
+    time.tv_usec = 0;
+    return (select(tty->fd_in + 1, &readset, NULL, NULL, &time) == 1);
+  }
+  #else
+  return false;
+  #endif
+}
+
+#if defined(TIOCSTI)
 ic_private bool tty_async_stop(const tty_t* tty) {
   // insert ^C in the input stream
   char c = KEY_CTRL_C;
@@ -9,6 +9,7 @@
 #define IC_TTY_H
 
 #include "common.h"
+#include "stringbuf.h"
 
 //-------------------------------------------------------------
 // TTY/Keyboard input 
@@ -32,11 +33,14 @@ ic_private code_t tty_read(tty_t* tty);
 ic_private bool   tty_read_timeout(tty_t* tty, long timeout_ms, code_t* c );
 
 ic_private void   tty_code_pushback( tty_t* tty, code_t c );
+ic_private int     tty_get_fd(const tty_t* tty);                    // the input file descriptor (to wait on)
+ic_private ssize_t tty_feed(tty_t* tty, const char* s, ssize_t n);  // push input bytes; returns how many were accepted
 ic_private bool   code_is_ascii_char(code_t c, char* chr );
 ic_private bool   code_is_unicode(code_t c, unicode_t* uchr);
 ic_private bool   code_is_virt_key(code_t c );
 
 ic_private bool   tty_term_resize_event(tty_t* tty); // did the terminal resize?
+ic_private bool   tty_has_input(tty_t* tty);         // is input available? (does not consume any)
 ic_private bool   tty_async_stop(const tty_t* tty);  // unblock the read asynchronously
 ic_private void   tty_set_esc_delay(tty_t* tty, long initial_delay_ms, long followup_delay_ms);
 
@@ -47,7 +51,10 @@ ic_private bool   tty_readc_noblock(tty_t* tty, uint8_t* c, long timeout_ms);
 ic_private code_t tty_read_esc(tty_t* tty, long esc_initial_timeout, long esc_timeout); // in tty_esc.c
 
 // used by term.c to read back ANSI escape responses
-ic_private bool   tty_read_esc_response(tty_t* tty, char esc_start, bool final_st, char* buf, ssize_t buflen ); 
+ic_private bool   tty_read_esc_response(tty_t* tty, char esc_start, bool final_st, char* buf, ssize_t buflen );
+
+// read the contents of a bracketed paste (after a KEY_EVENT_PASTE_START)
+ic_private bool   tty_read_bracketed_paste(tty_t* tty, stringbuf_t* sbuf);
 
 
 //-------------------------------------------------------------
@@ -142,6 +149,8 @@ static inline code_t key_unicode( unicode_t u ) {
 #define KEY_EVENT_RESIZE  (KEY_EVENT_BASE+1)
 #define KEY_EVENT_AUTOTAB (KEY_EVENT_BASE+2)
 #define KEY_EVENT_STOP    (KEY_EVENT_BASE+3)
+#define KEY_EVENT_PASTE_START (KEY_EVENT_BASE+4)  // bracketed paste: ESC [ 200 ~
+#define KEY_EVENT_PASTE_END   (KEY_EVENT_BASE+5)  // bracketed paste: ESC [ 201 ~
 
 // Convenience
 #define KEY_CTRL_UP       (WITH_CTRL(KEY_UP))
@@ -131,8 +131,10 @@ static code_t esc_decode_vt(uint32_t vt_code ) {
     case 5: return KEY_PAGEUP;
     case 6: return KEY_PAGEDOWN;
     case 7: return KEY_HOME;
-    case 8: return KEY_END;          
-    default: 
+    case 8: return KEY_END;
+    case 200: return KEY_EVENT_PASTE_START;  // bracketed paste
+    case 201: return KEY_EVENT_PASTE_END;
+    default:
       if (vt_code >= 10 && vt_code <= 15) return KEY_F(1  + (vt_code - 10));
       if (vt_code == 16) return KEY_F5; // minicom
       if (vt_code >= 17 && vt_code <= 21) return KEY_F(6  + (vt_code - 17));
@@ -223,22 +225,37 @@ static code_t esc_decode_ss3( uint8_t ss3_code ) {
   return KEY_NONE;
 }
 
-static void tty_read_csi_num(tty_t* tty, uint8_t* ppeek, uint32_t* num, long esc_timeout) {
-  *num = 1; // default
-  ssize_t count = 0;
-  uint32_t i = 0;
-  while (*ppeek >= '0' && *ppeek <= '9' && count < 16) {    
-    uint8_t digit = *ppeek - '0';
-    if (!tty_readc_noblock(tty,ppeek,esc_timeout)) break;  // peek is not modified in this case 
-    count++;
-    i = 10*i + digit; 
-  }
-  if (count > 0) *num = i;
+// Byte classes for the parameter part of a CSI/SS3 sequence; any other
+// byte terminates the sequence (we do not allow 'intermediate characters').
+typedef enum esc_class_e {
+  ECLASS_OTHER = 0,  // terminates the sequence (the "final" character)
+  ECLASS_DIGIT,      // [0-9]
+  ECLASS_SEMI,       // ';'
+  ECLASS_SPECIAL     // [:<=>?]  (only allowed as the first character)
+} esc_class_t;
+
+// All parameter bytes fall in the 0x30-0x3F range so a 16 entry table suffices.
+static const uint8_t esc_class_param[16] = {
+  ECLASS_DIGIT, ECLASS_DIGIT, ECLASS_DIGIT, ECLASS_DIGIT, ECLASS_DIGIT,    // 0-4
+  ECLASS_DIGIT, ECLASS_DIGIT, ECLASS_DIGIT, ECLASS_DIGIT, ECLASS_DIGIT,    // 5-9
+  ECLASS_SPECIAL, ECLASS_SEMI,                                             // : ;
+  ECLASS_SPECIAL, ECLASS_SPECIAL, ECLASS_SPECIAL, ECLASS_SPECIAL           // < = > ?
+};
+
+static esc_class_t esc_class_of(uint8_t c) {
+  return (c >= 0x30 && c <= 0x3F ? (esc_class_t)esc_class_param[c - 0x30] : ECLASS_OTHER);
 }
 
+// Parser states for the `special? (number (';' modifiers)?)? final` form.
+typedef enum esc_state_e {
+  ESTATE_START,   // expect a special character, a parameter, or the final character
+  ESTATE_NUM1,    // in the first parameter
+  ESTATE_NUM2    // in the second parameter (after ';')
+} esc_state_t;
+
 static code_t tty_read_csi(tty_t* tty, uint8_t c1, uint8_t peek, code_t mods0, long esc_timeout) {
   // CSI starts with 0x9b (c1=='[') | ESC [ (c1=='[') | ESC [Oo?] (c1 == 'O')  /* = SS3 */
-  
+
   // check for extra starter '[' (Linux sends ESC [ [ 15 ~  for F5 for example)
   if (c1 == '[' && strchr("[Oo", (char)peek) != NULL) {
     uint8_t cx = peek;
@@ -247,28 +264,64 @@ static code_t tty_read_csi(tty_t* tty, uint8_t c1, uint8_t peek, code_t mods0, l
     }
   }
 
-  // "special" characters ('?' is used for private sequences)
-  uint8_t special = 0;
-  if (strchr(":<=>?",(char)peek) != NULL) { 
-    special = peek;
-    if (!tty_readc_noblock(tty,&peek,esc_timeout)) {  
-      tty_cpush_char(tty,special); // recover
-      return (key_unicode(c1) | KEY_MOD_ALT);       // Alt+<anychar>
-    }
-  }
-
-  // up to 2 parameters that default to 1
+  // Parse `special? (number (';' modifiers)?)? final` with a table driven
+  // state machine over the buffered bytes; since `tty_readc_noblock` reads all
+  // available input in one chunk this usually runs without further syscalls and
+  // only waits on a timeout when a sequence is genuinely incomplete.
+  uint8_t  special = 0;
   uint32_t num1 = 1;
   uint32_t num2 = 1;
-  tty_read_csi_num(tty,&peek,&num1,esc_timeout);
-  if (peek == ';') {
-    if (!tty_readc_noblock(tty,&peek,esc_timeout)) return KEY_NONE;
-    tty_read_csi_num(tty,&peek,&num2,esc_timeout);
+  uint32_t acc = 0;       // current parameter accumulator
+  ssize_t  ndigits = 0;
+  uint8_t  final = 0;
+  bool     done = false;
+  esc_state_t state = ESTATE_START;
+  while (!done) {
+    switch (esc_class_of(peek)) {
+      case ECLASS_SPECIAL: {   // "special" characters ('?' is used for private sequences)
+        if (state != ESTATE_START) { final = peek; done = true; break; }
+        special = peek;
+        state = ESTATE_NUM1;
+        if (!tty_readc_noblock(tty,&peek,esc_timeout)) {
+          tty_cpush_char(tty,special); // recover
+          return (key_unicode(c1) | KEY_MOD_ALT);       // Alt+<anychar>
+        }
+        break;
+      }
+      case ECLASS_DIGIT: {
+        if (ndigits >= 16) { final = peek; done = true; break; }  // avoid overflow
+        const uint8_t digit = peek - '0';
+        if (!tty_readc_noblock(tty,&peek,esc_timeout)) {
+          final = peek;  // an unterminated number: treat its last digit as the final character
+          done = true;
+          break;
+        }
+        acc = 10*acc + digit;
+        ndigits++;
+        if (state == ESTATE_START) { state = ESTATE_NUM1; }
+        break;
+      }
+      case ECLASS_SEMI: {
+        if (state == ESTATE_NUM2) { final = peek; done = true; break; }  // at most 2 parameters
+        if (ndigits > 0) { num1 = acc; }
+        acc = 0; ndigits = 0;
+        state = ESTATE_NUM2;
+        if (!tty_readc_noblock(tty,&peek,esc_timeout)) return KEY_NONE;
+        break;
+      }
+      case ECLASS_OTHER:
+      default: {
+        final = peek;
+        done = true;
+        break;
+      }
+    }
   }
-
-  // the final character (we do not allow 'intermediate characters')
-  uint8_t final = peek;
-  code_t  modifiers = mods0;
+  if (ndigits > 0) {
+    if (state == ESTATE_NUM2) { num2 = acc; }
+    else { num1 = acc; }
+  }
+  code_t modifiers = mods0;
 
   debug_msg("tty: escape sequence: ESC %c %c %d;%d %c\n", c1, (special == 0 ? '_' : special), num1, num2, final);
   
@@ -15,53 +15,179 @@
 #include "undo.h"
 
 
-
 //-------------------------------------------------------------
 // edit state
+//
+// Undo states are kept as deltas: the top of the stack is always
+// a full snapshot, and every entry below it only records the span
+// that differs from the (full) state captured just after it. This
+// keeps memory O(change) per capture instead of O(buffer).
+// Entries and delta spans are bump-allocated from a per-session
+// arena and released wholesale when the session ends.
 //-------------------------------------------------------------
-struct editstate_s {
-  struct editstate_s* next;
-  const char* input;          // input
+
+#define IC_UNDO_BLOCK_SIZE  (4096)
+#define IC_UNDO_SNAPSHOT    (16)          // keep a full snapshot every N captures
+
+typedef struct undoblock_s {
+  struct undoblock_s* next;
+  ssize_t size;               // total data size
+  ssize_t used;
+  char*   data;               // points just after this header
+} undoblock_t;
+
+typedef struct editentry_s {
+  struct editentry_s* next;   // older state
   ssize_t     pos;            // cursor position
+  const char* input;          // full snapshot, or NULL if stored as a delta
+  // delta against the full text of the entry captured after this one:
+  ssize_t     dstart;         // start of the changed span
+  ssize_t     ddel_len;       // bytes to remove from the newer text at `dstart`
+  const char* dins;           // bytes to insert instead (arena allocated)
+  ssize_t     dins_len;
+} editentry_t;
+
+struct editstate_s {
+  editentry_t* entries;       // top of the stack; most recent capture first
+  ssize_t      captures;      // capture count (for periodic full snapshots)
+  undoblock_t* arena;         // arena blocks for entries and delta spans
+  alloc_t*     mem;
 };
 
-ic_private void editstate_init( editstate_t** es ) {
-  *es = NULL;
+//-------------------------------------------------------------
+// Arena
+//-------------------------------------------------------------
+
+static void* editstate_arena_alloc( editstate_t* es, ssize_t sz ) {
+  sz = (sz + 7) & ~((ssize_t)7);  // keep allocations pointer aligned
+  if (es->arena == NULL || es->arena->used + sz > es->arena->size) {
+    ssize_t bsize = (sz > IC_UNDO_BLOCK_SIZE ? sz : IC_UNDO_BLOCK_SIZE);
+    undoblock_t* b = (undoblock_t*)mem_malloc( es->mem, ssizeof(undoblock_t) + bsize );
+    if (b == NULL) return NULL;
+    b->size = bsize;
+    b->used = 0;
+    b->data = (char*)(b + 1);
+    b->next = es->arena;
+    es->arena = b;
+  }
+  void* p = es->arena->data + es->arena->used;
+  es->arena->used += sz;
+  return p;
+}
+
+//-------------------------------------------------------------
+// Capture and restore
+//-------------------------------------------------------------
+
+ic_private void editstate_init( alloc_t* mem, editstate_t** es ) {
+  *es = mem_zalloc_tp(mem, editstate_t);
+  if (*es != NULL) { (*es)->mem = mem; }
 }
 
-ic_private void editstate_done( alloc_t* mem, editstate_t** es ) {
-  while (*es != NULL) {
-    editstate_t* next = (*es)->next;
-    mem_free(mem, (*es)->input);
-    mem_free(mem, *es );
-    *es = next;
+ic_private void editstate_clear( editstate_t* es ) {
+  if (es == NULL) return;
+  // full snapshots are owned by `mem` (ownership transfers on restore)
+  for (editentry_t* entry = es->entries; entry != NULL; entry = entry->next) {
+    mem_free(es->mem, entry->input);
+  }
+  es->entries = NULL;
+  es->captures = 0;
+  // release the arena wholesale
+  while (es->arena != NULL) {
+    undoblock_t* next = es->arena->next;
+    mem_free(es->mem, es->arena);
+    es->arena = next;
   }
+}
+
+ic_private void editstate_done( editstate_t** es ) {
+  if (*es == NULL) return;
+  alloc_t* mem = (*es)->mem;
+  editstate_clear(*es);
+  mem_free(mem, *es);
   *es = NULL;
 }
 
-ic_private void editstate_capture( alloc_t* mem, editstate_t** es, const char* input, ssize_t pos) {
-  if (input==NULL) input = "";
+ic_private bool editstate_is_empty( const editstate_t* es ) {
+  return (es == NULL || es->entries == NULL);
+}
+
+// turn `entry` (a full snapshot) into a delta against the newer text `input`
+static void editentry_to_delta( editstate_t* es, editentry_t* entry, const char* input, ssize_t len ) {
+  const char* old = entry->input;
+  const ssize_t olen = ic_strlen(old);
+  // common prefix and suffix
+  ssize_t prefix = 0;
+  const ssize_t maxcommon = (olen < len ? olen : len);
+  while (prefix < maxcommon && old[prefix] == input[prefix]) { prefix++; }
+  ssize_t suffix = 0;
+  while (suffix < maxcommon - prefix && old[olen - suffix - 1] == input[len - suffix - 1]) { suffix++; }
+  const ssize_t dins_len = olen - prefix - suffix;
+  char* dins = NULL;
+  if (dins_len > 0) {
+    dins = (char*)editstate_arena_alloc(es, dins_len);
+    if (dins == NULL) return;  // keep the full snapshot
+    ic_memcpy(dins, old + prefix, dins_len);
+  }
+  entry->dstart   = prefix;
+  entry->ddel_len = len - prefix - suffix;
+  entry->dins     = dins;
+  entry->dins_len = dins_len;
+  mem_free(es->mem, entry->input);
+  entry->input = NULL;
+}
+
+ic_private void editstate_capture( editstate_t* es, const char* input, ssize_t pos ) {
+  if (es == NULL) return;
+  if (input == NULL) input = "";
   // alloc
-  editstate_t* entry = mem_zalloc_tp(mem, editstate_t);
+  editentry_t* entry = (editentry_t*)editstate_arena_alloc(es, ssizeof(editentry_t));
   if (entry == NULL) return;
-  // initialize
-  entry->input = mem_strdup( mem, input);
+  memset(entry, 0, sizeof(*entry));
+  entry->input = mem_strdup(es->mem, input);
   entry->pos   = pos;
-  if (entry->input == NULL) { mem_free(mem, entry); return; }
+  if (entry->input == NULL) return;
+  // demote the previous top to a delta (keeping a periodic full snapshot
+  // bounds the restore cost if a later materialization fails)
+  es->captures++;
+  if (es->entries != NULL && es->entries->input != NULL && (es->captures % IC_UNDO_SNAPSHOT) != 0) {
+    editentry_to_delta(es, es->entries, input, ic_strlen(input));
+  }
   // and push
-  entry->next = *es;
-  *es = entry;
+  entry->next = es->entries;
+  es->entries = entry;
 }
 
 // caller should free *input
-ic_private bool editstate_restore( alloc_t* mem, editstate_t** es, const char** input, ssize_t* pos ) {
-  if (*es == NULL) return false;
-  // pop 
-  editstate_t* entry = *es;
-  *es = entry->next;
+ic_private bool editstate_restore( editstate_t* es, const char** input, ssize_t* pos ) {
+  if (editstate_is_empty(es)) return false;
+  // pop; the top is always a full snapshot
+  editentry_t* entry = es->entries;
+  es->entries = entry->next;
+  assert(entry->input != NULL);
   *input = entry->input;
   *pos = entry->pos;
-  mem_free(mem, entry);
+  // materialize the new top from the delta against the popped text
+  editentry_t* top = es->entries;
+  if (top != NULL && top->input == NULL) {
+    const ssize_t len = ic_strlen(*input);
+    const ssize_t tlen = len - top->ddel_len + top->dins_len;
+    char* t = (char*)mem_malloc(es->mem, tlen + 1);
+    if (t == NULL) {
+      // cannot reconstruct older states anymore; drop them
+      for (editentry_t* e = es->entries; e != NULL; e = e->next) {
+        mem_free(es->mem, e->input);
+      }
+      es->entries = NULL;
+    }
+    else {
+      ic_memcpy(t, *input, top->dstart);
+      if (top->dins_len > 0) { ic_memcpy(t + top->dstart, top->dins, top->dins_len); }
+      ic_memcpy(t + top->dstart + top->dins_len, *input + top->dstart + top->ddel_len,
+                 len - top->dstart - top->ddel_len);
+      t[tlen] = 0;
+      top->input = t;
+    }
+  }
   return true;
 }
-
@@ -12,13 +12,16 @@
 
 //-------------------------------------------------------------
 // Edit state
+// A stack of delta-encoded undo states backed by a per-session arena.
 //-------------------------------------------------------------
 struct editstate_s;
 typedef struct editstate_s editstate_t;
 
-ic_private void editstate_init( editstate_t** es );
-ic_private void editstate_done( alloc_t* mem, editstate_t** es );
-ic_private void editstate_capture( alloc_t* mem, editstate_t** es, const char* input, ssize_t pos);
-ic_private bool editstate_restore( alloc_t* mem, editstate_t** es, const char** input, ssize_t* pos ); // caller needs to free input
+ic_private void editstate_init( alloc_t* mem, editstate_t** es );
+ic_private void editstate_done( editstate_t** es );
+ic_private void editstate_clear( editstate_t* es );     // forget all states but keep the session
+ic_private bool editstate_is_empty( const editstate_t* es );
+ic_private void editstate_capture( editstate_t* es, const char* input, ssize_t pos);
+ic_private bool editstate_restore( editstate_t* es, const char** input, ssize_t* pos ); // caller needs to free input
 
 #endif // IC_UNDO_H
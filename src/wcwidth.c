@@ -163,7 +163,7 @@ static int mk_is_wide_char(int32_t ucs) {
   return 0;
 }
 
-static int mk_wcwidth(int32_t ucs) {
+static int mk_wcwidth_scan(int32_t ucs) {
 	/* sorted list of non-overlapping intervals of non-spacing characters */
 	/* generated by "uniset +cat=Me +cat=Mn +cat=Cf -00AD +1160-11FF +200B c" */
 	static const struct interval combining[] = {
@@ -290,3 +290,64 @@ static int mk_wcwidth(int32_t ucs) {
   return ( mk_is_wide_char( ucs ) ? 2 : 1 );
 }
 
+
+/* Two-level lookup table over the BMP: a page index selects a 2-bit packed
+ * page of 256 widths so classifying a codepoint is two array loads instead
+ * of two binary searches. The table is built once on first use from
+ * `mk_wcwidth_scan` so the interval tables above stay the single source of
+ * truth. Identical pages are shared: most pages are uniformly single-width
+ * so the pool stays small (~6KiB touched). Codepoints above the BMP go
+ * through a small width cache backed by the binary search. */
+
+#define WW_PAGE_SIZE   (256)                  /* codepoints per level-2 page */
+#define WW_PAGE_BYTES  (WW_PAGE_SIZE/4)       /* 2 bits per codepoint */
+#define WW_BMP_PAGES   (0x10000/WW_PAGE_SIZE)
+
+static uint8_t ww_pageidx[WW_BMP_PAGES];            /* level 1: page -> pool index */
+static uint8_t ww_pages[WW_BMP_PAGES*WW_PAGE_BYTES];/* level 2: packed (width+1) entries */
+static int     ww_page_count = 0;                   /* distinct pages (0 = not yet built) */
+
+static void mk_wcwidth_build(void) {
+  uint8_t page[WW_PAGE_BYTES];
+  int count = 0;
+  for (int p = 0; p < WW_BMP_PAGES; p++) {
+    memset(page, 0, sizeof(page));
+    for (int i = 0; i < WW_PAGE_SIZE; i++) {
+      const int w = mk_wcwidth_scan(p*WW_PAGE_SIZE + i) + 1;  /* -1..2 ~> 0..3 */
+      page[i/4] |= (uint8_t)(w << (2*(i%4)));
+    }
+    int idx = 0;
+    while (idx < count && memcmp(ww_pages + (size_t)idx*WW_PAGE_BYTES, page, WW_PAGE_BYTES) != 0) {
+      idx++;
+    }
+    if (idx == count) {
+      memcpy(ww_pages + (size_t)idx*WW_PAGE_BYTES, page, WW_PAGE_BYTES);
+      count++;
+    }
+    ww_pageidx[p] = (uint8_t)idx;
+  }
+  ww_page_count = count;  /* set last: rebuilding concurrently is idempotent */
+}
+
+/* direct-mapped cache for codepoints above the BMP (emoji etc.) so repeated
+ * measurement of the same character avoids the binary search */
+#define WW_CACHE_SIZE  (128)
+static int32_t ww_cache_cp[WW_CACHE_SIZE];  /* 0 is empty */
+static int8_t  ww_cache_w[WW_CACHE_SIZE];
+
+static int mk_wcwidth(int32_t ucs) {
+  if ((uint32_t)ucs < 0x10000) {
+    if (ww_page_count == 0) { mk_wcwidth_build(); }
+    const uint8_t b = ww_pages[ (size_t)ww_pageidx[ucs/WW_PAGE_SIZE]*WW_PAGE_BYTES + (size_t)(ucs%WW_PAGE_SIZE)/4 ];
+    return (int)((b >> (2*(ucs%4))) & 3) - 1;
+  }
+  else {
+    const int i = (int)((ucs ^ (ucs >> 7)) & (WW_CACHE_SIZE-1));
+    if (ww_cache_cp[i] != ucs) {
+      ww_cache_cp[i] = ucs;
+      ww_cache_w[i]  = (int8_t)mk_wcwidth_scan(ucs);
+    }
+    return ww_cache_w[i];
+  }
+}
+
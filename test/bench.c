@@ -0,0 +1,311 @@
+/* ----------------------------------------------------------------------------
+  Copyright (c) 2021, Daan Leijen
+  This is free software; you can redistribute it and/or modify it
+  under the terms of the MIT License. A copy of the license can be
+  found in the "LICENSE" file at the root of this distribution.
+
+  Performance benchmarks: keystroke latency, refresh throughput, history
+  search, and bbcode printing. The benchmarks drive the internal editor
+  directly (and `edit_line` itself through synthetic tty input) against a
+  terminal writing to /dev/null, so timings reflect library work only.
+  Build with the `bench` target and run `./bench`.
+-----------------------------------------------------------------------------*/
+#if defined(_WIN32)
+#include <stdio.h>
+int main(void) {
+  printf("bench: only supported on unix-like platforms\n");
+  return 0;
+}
+#else
+
+#include "../src/isocline.c"   // access to internal (static) functions
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <time.h>
+
+//-------------------------------------------------------------
+// Timing helpers
+//-------------------------------------------------------------
+
+static double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static int bench_cmp_double(const void* pa, const void* pb) {
+  const double a = *(const double*)pa;
+  const double b = *(const double*)pb;
+  return (a < b ? -1 : (a > b ? 1 : 0));
+}
+
+// report a latency distribution in microseconds
+static void bench_report_dist(const char* name, double* samples, ssize_t count) {
+  qsort(samples, to_size_t(count), sizeof(double), &bench_cmp_double);
+  double sum = 0.0;
+  for (ssize_t i = 0; i < count; i++) { sum += samples[i]; }
+  printf("  %-28s mean %8.1fus  p50 %8.1fus  p90 %8.1fus  p99 %8.1fus  max %8.1fus\n",
+          name, 1e6 * sum / (double)count,
+          1e6 * samples[count/2], 1e6 * samples[(9*count)/10],
+          1e6 * samples[(99*count)/100], 1e6 * samples[count-1]);
+}
+
+//-------------------------------------------------------------
+// Environment: a real tty (from a pty pair, so synthetic input
+// can be pushed) and a terminal writing to /dev/null.
+//-------------------------------------------------------------
+
+static int bench_pty_master = -1;
+
+static ic_env_t* bench_env_new(void) {
+  alloc_t* mem = (alloc_t*)malloc(sizeof(alloc_t));
+  if (mem == NULL) return NULL;
+  mem->malloc = &malloc;
+  mem->realloc = &realloc;
+  mem->free = &free;
+  mem->arena = NULL;
+  ic_env_t* env = mem_zalloc_tp(mem, ic_env_t);
+  if (env == NULL) return NULL;
+  env->mem = mem;
+  // keyboard input from the slave side of a pty pair
+  bench_pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+  int fd_in = -1;
+  if (bench_pty_master >= 0 && grantpt(bench_pty_master) == 0 && unlockpt(bench_pty_master) == 0) {
+    fd_in = open(ptsname(bench_pty_master), O_RDWR | O_NOCTTY);
+  }
+  if (fd_in < 0) {
+    fprintf(stderr, "bench: cannot open a pty pair\n");
+    return NULL;
+  }
+  env->tty = tty_new(env->mem, fd_in);
+  // terminal output to /dev/null
+  const int fd_out = open("/dev/null", O_WRONLY);
+  env->term = term_new(env->mem, env->tty, false, true, fd_out);
+  env->history = history_new(env->mem);
+  env->completions = completions_new(env->mem);
+  env->bbcode = bbcode_new(env->mem, env->term);
+  if (env->tty == NULL || env->term == NULL || env->history == NULL ||
+       env->completions == NULL || env->bbcode == NULL) {
+    fprintf(stderr, "bench: cannot initialize environment\n");
+    return NULL;
+  }
+  // /dev/null is not a tty so color was disabled; re-enable so the
+  // benchmarks include escape sequence generation
+  env->term->nocolor = false;
+  env->term->palette = ANSI256;
+  set_prompt_marker(env, NULL, NULL);
+  return env;
+}
+
+//-------------------------------------------------------------
+// Editor setup (mirrors the setup in edit_line)
+//-------------------------------------------------------------
+
+static void bench_editor_init(ic_env_t* env, editor_t* eb, ssize_t content_len, ssize_t termw) {
+  memset(eb, 0, sizeof(*eb));
+  eb->mem = env->mem;
+  eb->input = sbuf_new(env->mem);
+  sbuf_set_gap_buffer(eb->input, true);
+  eb->extra = sbuf_new(env->mem);
+  eb->hint = sbuf_new(env->mem);
+  eb->hint_help = sbuf_new(env->mem);
+  eb->termw = termw;
+  eb->cur_rows = 1;
+  eb->prompt_text = "";
+  editstate_init(env->mem, &eb->undo);
+  editstate_init(env->mem, &eb->redo);
+  rcache_init(&eb->rcache, env->mem);
+  eb->attrs = attrbuf_new(env->mem);
+  eb->attrs_extra = attrbuf_new(env->mem);
+  // fill with lines of text up to `content_len` bytes
+  while (sbuf_len(eb->input) < content_len) {
+    sbuf_append(eb->input, "let answer = fib (n - 1) + fib (n - 2)  -- reasonably wide line\n");
+  }
+  eb->pos = sbuf_len(eb->input);
+}
+
+static void bench_editor_done(editor_t* eb) {
+  editstate_done(&eb->undo);
+  editstate_done(&eb->redo);
+  rcache_done(&eb->rcache);
+  attrbuf_free(eb->attrs);
+  attrbuf_free(eb->attrs_extra);
+  sbuf_free(eb->input);
+  sbuf_free(eb->extra);
+  sbuf_free(eb->hint);
+  sbuf_free(eb->hint_help);
+}
+
+//-------------------------------------------------------------
+// 1. Per-keystroke latency for N-KB buffers
+//    (one keystroke = insert at the cursor + full refresh)
+//-------------------------------------------------------------
+
+#define BENCH_KEYSTROKES (100)
+
+static void bench_keystrokes(ic_env_t* env) {
+  printf("keystroke latency (insert + refresh, 80 columns):\n");
+  static const ssize_t sizes[] = { 1, 16, 64 };
+  double samples[BENCH_KEYSTROKES];
+  for (ssize_t s = 0; s < ssizeof(sizes)/ssizeof(sizes[0]); s++) {
+    editor_t eb;
+    bench_editor_init(env, &eb, sizes[s]*1024, 80);
+    edit_refresh(env, &eb);  // warm the caches
+    for (ssize_t i = 0; i < BENCH_KEYSTROKES; i++) {
+      const double t0 = bench_now();
+      edit_insert_char(env, &eb, (i%10 == 9 ? ' ' : 'x'));
+      edit_refresh(env, &eb);
+      samples[i] = bench_now() - t0;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "%zdKB buffer", sizes[s]);
+    bench_report_dist(name, samples, BENCH_KEYSTROKES);
+    bench_editor_done(&eb);
+  }
+}
+
+//-------------------------------------------------------------
+// 2. edit_refresh cost vs input size and terminal width
+//-------------------------------------------------------------
+
+static void bench_refresh(ic_env_t* env) {
+  printf("edit_refresh cost (cold = full relayout, warm = cached):\n");
+  static const ssize_t sizes[] = { 4, 64, 256 };
+  static const ssize_t widths[] = { 40, 80, 160 };
+  for (ssize_t s = 0; s < ssizeof(sizes)/ssizeof(sizes[0]); s++) {
+    for (ssize_t w = 0; w < ssizeof(widths)/ssizeof(widths[0]); w++) {
+      editor_t eb;
+      bench_editor_init(env, &eb, sizes[s]*1024, widths[w]);
+      const double t0 = bench_now();
+      edit_refresh(env, &eb);
+      const double cold = bench_now() - t0;
+      const ssize_t repeat = (sizes[s] >= 256 ? 3 : 20);
+      const double t1 = bench_now();
+      for (ssize_t i = 0; i < repeat; i++) { edit_refresh(env, &eb); }
+      const double warm = (bench_now() - t1) / (double)repeat;
+      printf("  %3zdKB %3zd cols: cold %8.1fus  warm %8.1fus\n",
+              sizes[s], widths[w], 1e6*cold, 1e6*warm);
+      bench_editor_done(&eb);
+    }
+  }
+}
+
+//-------------------------------------------------------------
+// 3. edit_line end-to-end through synthetic tty input
+//    (a child process feeds keystrokes into the pty master)
+//-------------------------------------------------------------
+
+static void bench_edit_line(ic_env_t* env) {
+  printf("edit_line end-to-end (keystrokes fed through the tty):\n");
+  static const ssize_t sizes[] = { 1, 4, 16 };
+  for (ssize_t s = 0; s < ssizeof(sizes)/ssizeof(sizes[0]); s++) {
+    const ssize_t n = sizes[s]*1024;
+    const pid_t pid = fork();
+    if (pid == 0) {
+      // feeder: n printable keystrokes followed by return
+      char buf[256];
+      for (ssize_t i = 0; i < ssizeof(buf); i++) { buf[i] = (char)('a' + (i % 26)); }
+      ssize_t todo = n;
+      while (todo > 0) {
+        const ssize_t chunk = (todo < ssizeof(buf) ? todo : ssizeof(buf));
+        if (write(bench_pty_master, buf, to_size_t(chunk)) < 0) { _exit(1); }
+        todo -= chunk;
+      }
+      if (write(bench_pty_master, "\r", 1) < 0) { _exit(1); }
+      _exit(0);
+    }
+    tty_start_raw(env->tty);
+    term_start_raw(env->term);
+    const double t0 = bench_now();
+    char* line = edit_line(env, "bench");
+    const double elapsed = bench_now() - t0;
+    term_end_raw(env->term, false);
+    tty_end_raw(env->tty);
+    const ssize_t len = ic_strlen(line);
+    printf("  %3zdKB input: %8.3fs total, %8.1fus/keystroke%s\n",
+            sizes[s], elapsed, 1e6*elapsed/(double)n, (len == n ? "" : "  (length mismatch!)"));
+    mem_free(env->mem, line);
+    waitpid(pid, NULL, 0);
+  }
+}
+
+//-------------------------------------------------------------
+// 4. history_search time vs entry count
+//-------------------------------------------------------------
+
+static void bench_history(ic_env_t* env) {
+  printf("history_search (backward from the most recent entry):\n");
+  static const ssize_t counts[] = { 10, 50, 200 };  // IC_MAX_HISTORY caps the entry count
+  for (ssize_t c = 0; c < ssizeof(counts)/ssizeof(counts[0]); c++) {
+    history_t* h = history_new(env->mem);
+    history_load_from(h, NULL, (long)counts[c] + 1);  // no file; sets the max entry count
+    history_enable_duplicates(h, true);
+    char entry[128];
+    for (ssize_t i = 0; i < counts[c]; i++) {
+      snprintf(entry, sizeof(entry), "make target-%zd CFLAGS='-O2 -g' && ./run --seed %zd", i, i*7919);
+      history_push(h, entry);
+    }
+    ssize_t hidx = 0; ssize_t hpos = 0;
+    const ssize_t repeat = 1000;
+    bool found = true;
+    double t0 = bench_now();
+    for (ssize_t i = 0; i < repeat; i++) {
+      found = history_search(h, 0, "seed 7919", true, &hidx, &hpos) && found;  // matches once, deep in the history
+    }
+    const double hit = (bench_now() - t0) / (double)repeat;
+    t0 = bench_now();
+    for (ssize_t i = 0; i < repeat; i++) {
+      history_search(h, 0, "no such entry", true, &hidx, &hpos);  // scans everything
+    }
+    const double miss = (bench_now() - t0) / (double)repeat;
+    printf("  %6zd entries: deep hit %8.2fus%s  miss %8.2fus\n", counts[c],
+            1e6*hit, (found ? "" : " (not found!)"), 1e6*miss);
+    history_free(h);
+  }
+}
+
+//-------------------------------------------------------------
+// 5. bbcode_print throughput
+//-------------------------------------------------------------
+
+static void bench_bbcode(ic_env_t* env) {
+  printf("bbcode_print throughput:\n");
+  ic_style_def("kw", "bold color=#569cd6");
+  ic_style_def("str", "color=#ce9178");
+  const char* line =
+    "[kw]for[/kw] i [kw]in[/kw] range(10): print([str]\"hello \\(i) world\"[/str])  "
+    "[i]# comment with [u]markup[/u] and [red]colors[/red][/i]\n";
+  const ssize_t len = ic_strlen(line);
+  const ssize_t repeat = 20000;
+  term_start_raw(env->term);  // buffered output
+  const double t0 = bench_now();
+  for (ssize_t i = 0; i < repeat; i++) {
+    bbcode_print(env->bbcode, line);
+  }
+  term_flush(env->term);
+  const double elapsed = bench_now() - t0;
+  term_end_raw(env->term, true);
+  printf("  %6.1f MB/s markup (%5.1fus per %zd-byte line)\n",
+          (double)(len*repeat) / (1024.0*1024.0) / elapsed, 1e6*elapsed/(double)repeat, len);
+}
+
+//-------------------------------------------------------------
+// Main
+//-------------------------------------------------------------
+
+int main(void) {
+  ic_env_t* env = bench_env_new();
+  if (env == NULL) return 1;
+  rpenv = env;  // also used through the public functions (ic_style_def)
+  printf("isocline benchmarks\n-------------------\n");
+  bench_keystrokes(env);
+  bench_refresh(env);
+  bench_edit_line(env);
+  bench_history(env);
+  bench_bbcode(env);
+  printf("done\n");
+  return 0;
+}
+
+#endif // !_WIN32